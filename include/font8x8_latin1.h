@@ -0,0 +1,53 @@
+// 8x8 Latin-1 supplement symbols (U+00A0-U+00FF), drawn to match
+// font8x8_basic. Accented letters are left empty: the glyph cache composes
+// them from the ASCII base letter and an accent.
+#ifndef FONT8X8_LATIN1_H
+#define FONT8X8_LATIN1_H
+
+static const unsigned char font8x8_latin1[96][8] = {
+    [0x00] = {0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00}, // U+00A0 no-break space
+    [0x01] = {0x18,0x00,0x18,0x18,0x3c,0x3c,0x18,0x00}, // U+00A1 inverted exclamation
+    [0x02] = {0x18,0x7c,0x06,0x06,0x06,0x7c,0x18,0x00}, // U+00A2 cent
+    [0x03] = {0x38,0x6c,0x0c,0x3e,0x0c,0x46,0x7f,0x00}, // U+00A3 pound
+    [0x04] = {0x00,0x63,0x3e,0x36,0x3e,0x63,0x00,0x00}, // U+00A4 currency
+    [0x05] = {0x33,0x33,0x1e,0x3f,0x0c,0x3f,0x0c,0x00}, // U+00A5 yen
+    [0x06] = {0x18,0x18,0x18,0x00,0x18,0x18,0x18,0x00}, // U+00A6 broken bar
+    [0x07] = {0x3c,0x06,0x1c,0x36,0x1c,0x30,0x1e,0x00}, // U+00A7 section
+    [0x08] = {0x66,0x00,0x00,0x00,0x00,0x00,0x00,0x00}, // U+00A8 diaeresis
+    [0x09] = {0x3c,0x42,0x99,0x85,0x85,0x99,0x42,0x3c}, // U+00A9 copyright
+    [0x0A] = {0x1c,0x30,0x3c,0x36,0x3c,0x00,0x3e,0x00}, // U+00AA feminine ordinal
+    [0x0B] = {0x00,0xcc,0x66,0x33,0x66,0xcc,0x00,0x00}, // U+00AB left guillemet
+    [0x0C] = {0x00,0x00,0x00,0x3f,0x30,0x30,0x00,0x00}, // U+00AC not
+    [0x0D] = {0x00,0x00,0x00,0x1e,0x00,0x00,0x00,0x00}, // U+00AD soft hyphen
+    [0x0E] = {0x3c,0x42,0x9d,0xa5,0x9d,0xa5,0x42,0x3c}, // U+00AE registered
+    [0x0F] = {0x3f,0x00,0x00,0x00,0x00,0x00,0x00,0x00}, // U+00AF macron
+    [0x10] = {0x1c,0x36,0x36,0x1c,0x00,0x00,0x00,0x00}, // U+00B0 degree
+    [0x11] = {0x18,0x18,0x7e,0x18,0x18,0x00,0x7e,0x00}, // U+00B1 plus-minus
+    [0x12] = {0x0e,0x18,0x0c,0x1e,0x00,0x00,0x00,0x00}, // U+00B2 superscript two
+    [0x13] = {0x0e,0x1c,0x18,0x0e,0x00,0x00,0x00,0x00}, // U+00B3 superscript three
+    [0x14] = {0x18,0x0c,0x00,0x00,0x00,0x00,0x00,0x00}, // U+00B4 acute accent
+    [0x15] = {0x00,0x00,0x66,0x66,0x66,0x3e,0x06,0x03}, // U+00B5 micro
+    [0x16] = {0xfe,0xdb,0xdb,0xde,0xd8,0xd8,0xd8,0x00}, // U+00B6 pilcrow
+    [0x17] = {0x00,0x00,0x00,0x18,0x18,0x00,0x00,0x00}, // U+00B7 middle dot
+    [0x18] = {0x00,0x00,0x00,0x00,0x00,0x18,0x30,0x1c}, // U+00B8 cedilla
+    [0x19] = {0x04,0x06,0x04,0x0e,0x00,0x00,0x00,0x00}, // U+00B9 superscript one
+    [0x1A] = {0x1c,0x36,0x36,0x1c,0x00,0x3e,0x00,0x00}, // U+00BA masculine ordinal
+    [0x1B] = {0x00,0x33,0x66,0xcc,0x66,0x33,0x00,0x00}, // U+00BB right guillemet
+    [0x1C] = {0x42,0x23,0x12,0x4a,0x64,0x52,0xf1,0x40}, // U+00BC one quarter
+    [0x1D] = {0x42,0x23,0x12,0x6a,0x94,0x42,0x21,0xe0}, // U+00BD one half
+    [0x1E] = {0x83,0x44,0x22,0x54,0x6b,0xa8,0xe4,0x40}, // U+00BE three quarters
+    [0x1F] = {0x18,0x00,0x18,0x0c,0x06,0x66,0x3c,0x00}, // U+00BF inverted question
+    [0x26] = {0x7c,0x36,0x33,0x7f,0x33,0x33,0x73,0x00}, // U+00C6 AE
+    [0x30] = {0x1f,0x36,0x66,0x6f,0x66,0x36,0x1f,0x00}, // U+00D0 Eth
+    [0x37] = {0x00,0x63,0x36,0x1c,0x36,0x63,0x00,0x00}, // U+00D7 multiplication
+    [0x38] = {0x5e,0x33,0x3b,0x6b,0x67,0x66,0x3d,0x00}, // U+00D8 O stroke
+    [0x3E] = {0x0f,0x06,0x3e,0x66,0x3e,0x06,0x0f,0x00}, // U+00DE Thorn
+    [0x3F] = {0x3c,0x66,0x66,0x36,0x66,0x66,0x36,0x06}, // U+00DF sharp s
+    [0x46] = {0x00,0x00,0x36,0x58,0x7e,0x1b,0x76,0x00}, // U+00E6 ae
+    [0x50] = {0x14,0x08,0x34,0x60,0x7c,0x66,0x3c,0x00}, // U+00F0 eth
+    [0x57] = {0x00,0x18,0x00,0x7e,0x00,0x18,0x00,0x00}, // U+00F7 division
+    [0x58] = {0x00,0x40,0x3c,0x76,0x6e,0x3c,0x02,0x00}, // U+00F8 o stroke
+    [0x5E] = {0x06,0x06,0x3e,0x66,0x3e,0x06,0x06,0x00}, // U+00FE thorn
+};
+
+#endif
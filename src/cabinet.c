@@ -2,6 +2,7 @@
 #include "cabinet.h"
 #include "terminal.h"
 #include "map.h"
+#include "renderer.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,6 +29,7 @@ static int find_free_terminal_slot(const Game *game) {
 
 void rebuild_cabinets(Game *game) {
     game->cabinet_count = 0;
+    game->world_version++;
 
 #if DEBUG_MODE
     printf("[DEBUG] rebuild_cabinets: Starting scan (map size: %dx%d)\n",
@@ -140,6 +142,11 @@ void activate_cabinet(Game *game, int cabinet_index) {
 
     Terminal *term = &game->terminals[term_idx];
 
+    // Cabinets are only viewed full-screen, so their grid fills the window
+    int cols, rows;
+    renderer_terminal_grid(&cols, &rows);
+    terminal_resize(term, cols, rows);
+
     // If terminal is not active, spawn a shell
     if (!term->active) {
         if (!terminal_spawn_shell(term)) {
@@ -183,6 +190,7 @@ bool remove_cabinet(Game *game, int cabinet_index) {
         game->cabinets[i] = game->cabinets[i + 1];
     }
     game->cabinet_count--;
+    game->world_version++;
     return true;
 }
 
@@ -232,6 +240,7 @@ bool place_cabinet(Game *game, int gx, int gy) {
     terminal_init(&game->terminals[entry->terminal_index]);
     game->map.decor[gy][gx] = 'C';
     game->cabinet_count++;
+    game->world_version++;
     return true;
 }
 
@@ -4,6 +4,7 @@
 #include "terminal.h"
 #include "utils.h"
 #include "map.h"
+#include "renderer.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -33,6 +34,18 @@ static inline bool is_open_space(const Game *game, int x, int y) {
     return !tile_is_wall(tile);
 }
 
+void display_grid_size(const DisplayEntry *display, int *cols, int *rows) {
+    // Displays are one tile high and span width x height tiles along the wall
+    int span = display->width * display->height;
+    int max_cols, max_rows;
+    renderer_terminal_grid(&max_cols, &max_rows);
+    *cols = span * DISPLAY_COLS_PER_TILE;
+    if (*cols > max_cols) {
+        *cols = max_cols;
+    }
+    *rows = TERM_ROWS < max_rows ? TERM_ROWS : max_rows;
+}
+
 void rebuild_displays(Game *game) {
     if (!game || !game->map.tiles || !game->map.decor) {
         return;
@@ -52,6 +65,7 @@ void rebuild_displays(Game *game) {
     }
 
     game->display_count = 0;
+    game->world_version++;
     bool terminal_used[MAX_TERMINALS] = {0};
     for (int i = 0; i < game->cabinet_count; ++i) {
         int idx = game->cabinets[i].terminal_index;
@@ -177,7 +191,10 @@ void rebuild_displays(Game *game) {
 
                 display->terminal_index = terminal_slot;
                 if (terminal_slot >= 0 && terminal_slot < MAX_TERMINALS) {
+                    int cols, rows;
+                    display_grid_size(display, &cols, &rows);
                     terminal_init(&game->terminals[terminal_slot]);
+                    terminal_resize(&game->terminals[terminal_slot], cols, rows);
                 } else {
 #if DEBUG_MODE
                     printf("[DEBUG] No free terminal slot for display %s\n", name_buf);
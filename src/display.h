@@ -6,6 +6,11 @@
 // Initialize displays from game state
 void rebuild_displays(Game *game);
 
+// Terminal grid for a display wall: DISPLAY_COLS_PER_TILE columns per tile
+// along the wall at the default row count, capped to fit terminal mode
+#define DISPLAY_COLS_PER_TILE 20
+void display_grid_size(const DisplayEntry *display, int *cols, int *rows);
+
 // Find display at grid position
 int find_display_at(const Game *game, int grid_x, int grid_y);
 
@@ -0,0 +1,273 @@
+// Floor span kernels (scalar, SSE2 and AVX2) for the lower half of the screen
+#include "floorcast.h"
+#include "map.h"
+#include "texture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#define FLOORCAST_X86 1
+#include <immintrin.h>
+#else
+#define FLOORCAST_X86 0
+#endif
+
+// Texel offset of each floor texture inside the flat floor_textures array;
+// mip level n shifts by n less per row and 2n less per texture
+#define FLOOR_TEX_SHIFT 12
+#define FLOOR_TEX_ROW_SHIFT 6
+
+// One mip level of the floor textures, as the span kernels address it
+typedef struct {
+    const uint32_t *texels;
+    int size;         // Texels per side
+    int rowShift;     // log2(size)
+    int textureShift; // log2(size * size)
+} FloorLevel;
+
+typedef void (*FloorSpanFunc)(uint32_t *dst, int count, double floorX, double floorY, double stepX, double stepY,
+                              const FloorLevel *level);
+
+// Floor texture index for every map cell, row-major. Padded so the AVX2 kernel
+// can gather it as 32-bit words without reading past the allocation.
+static uint8_t *floor_materials = NULL;
+static const void *floor_materials_source = NULL;
+static int floor_materials_width = 0;
+static int floor_materials_height = 0;
+
+static FloorSpanFunc floor_span_func = NULL;
+static const char *floor_span_name = "scalar";
+
+static void select_floor_kernel(void);
+
+void floorcast_prepare(const Map *map) {
+    if (!floor_span_func) {
+        select_floor_kernel();
+    }
+    if (!map || !map->tiles) {
+        return;
+    }
+    if (floor_materials && floor_materials_source == (const void *)map->tiles &&
+        floor_materials_width == map->width && floor_materials_height == map->height) {
+        return;
+    }
+
+    size_t cells = (size_t)map->width * (size_t)map->height;
+    uint8_t *materials = (uint8_t *)realloc(floor_materials, cells + sizeof(int32_t));
+    if (!materials) {
+        return;
+    }
+    for (int y = 0; y < map->height; ++y) {
+        for (int x = 0; x < map->width; ++x) {
+            materials[y * map->width + x] = (uint8_t)floor_index_for_char(map->tiles[y][x]);
+        }
+    }
+    memset(materials + cells, 0, sizeof(int32_t));
+
+    floor_materials = materials;
+    floor_materials_source = (const void *)map->tiles;
+    floor_materials_width = map->width;
+    floor_materials_height = map->height;
+}
+
+// Reference kernel for pixels [first, count). Positions are computed as base + x * step
+// (not accumulated) so every kernel, including its scalar tail, produces the same texels.
+static void floor_span_range(uint32_t *dst, int first, int count, double floorX, double floorY, double stepX,
+                             double stepY, const FloorLevel *level) {
+    const uint32_t *texels = level->texels;
+    int size = level->size;
+    int width = floor_materials_width;
+    int height = floor_materials_height;
+    for (int x = first; x < count; ++x) {
+        double offsetX = x * stepX;
+        double offsetY = x * stepY;
+        double fx = floorX + offsetX;
+        double fy = floorY + offsetY;
+        int cellX = (int)fx;
+        int cellY = (int)fy;
+        uint32_t color = FLOOR_VOID_COLOR;
+        if (cellX >= 0 && cellX < width && cellY >= 0 && cellY < height) {
+            int texX = (int)((fx - cellX) * size) & (size - 1);
+            int texY = (int)((fy - cellY) * size) & (size - 1);
+            int material = floor_materials[cellY * width + cellX];
+            color = texels[(material << level->textureShift) | (texY << level->rowShift) | texX];
+        }
+        dst[x] = color;
+    }
+}
+
+static void floor_span_scalar(uint32_t *dst, int count, double floorX, double floorY, double stepX,
+                              double stepY, const FloorLevel *level) {
+    floor_span_range(dst, 0, count, floorX, floorY, stepX, stepY, level);
+}
+
+#if FLOORCAST_X86
+// 4 pixels per iteration: coordinates in SSE2, texel fetches stay scalar (no gather)
+static void floor_span_sse2(uint32_t *dst, int count, double floorX, double floorY, double stepX,
+                            double stepY, const FloorLevel *level) {
+    const uint32_t *texels = level->texels;
+    int width = floor_materials_width;
+    int height = floor_materials_height;
+    const __m128d baseX = _mm_set1_pd(floorX);
+    const __m128d baseY = _mm_set1_pd(floorY);
+    const __m128d stepXv = _mm_set1_pd(stepX);
+    const __m128d stepYv = _mm_set1_pd(stepY);
+    const __m128d texScale = _mm_set1_pd((double)level->size);
+    const __m128i texMask = _mm_set1_epi32(level->size - 1);
+    const __m128i rowShift = _mm_cvtsi32_si128(level->rowShift);
+    const __m128i widthv = _mm_set1_epi32(width);
+    const __m128i heightv = _mm_set1_epi32(height);
+    const __m128i minusOne = _mm_set1_epi32(-1);
+
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128d xs0 = _mm_set_pd((double)(x + 1), (double)x);
+        __m128d xs1 = _mm_set_pd((double)(x + 3), (double)(x + 2));
+        __m128d fx0 = _mm_add_pd(baseX, _mm_mul_pd(xs0, stepXv));
+        __m128d fx1 = _mm_add_pd(baseX, _mm_mul_pd(xs1, stepXv));
+        __m128d fy0 = _mm_add_pd(baseY, _mm_mul_pd(xs0, stepYv));
+        __m128d fy1 = _mm_add_pd(baseY, _mm_mul_pd(xs1, stepYv));
+
+        __m128i cx0 = _mm_cvttpd_epi32(fx0);
+        __m128i cx1 = _mm_cvttpd_epi32(fx1);
+        __m128i cy0 = _mm_cvttpd_epi32(fy0);
+        __m128i cy1 = _mm_cvttpd_epi32(fy1);
+        __m128i tx0 = _mm_cvttpd_epi32(_mm_mul_pd(_mm_sub_pd(fx0, _mm_cvtepi32_pd(cx0)), texScale));
+        __m128i tx1 = _mm_cvttpd_epi32(_mm_mul_pd(_mm_sub_pd(fx1, _mm_cvtepi32_pd(cx1)), texScale));
+        __m128i ty0 = _mm_cvttpd_epi32(_mm_mul_pd(_mm_sub_pd(fy0, _mm_cvtepi32_pd(cy0)), texScale));
+        __m128i ty1 = _mm_cvttpd_epi32(_mm_mul_pd(_mm_sub_pd(fy1, _mm_cvtepi32_pd(cy1)), texScale));
+
+        __m128i cellX = _mm_unpacklo_epi64(cx0, cx1);
+        __m128i cellY = _mm_unpacklo_epi64(cy0, cy1);
+        __m128i texX = _mm_and_si128(_mm_unpacklo_epi64(tx0, tx1), texMask);
+        __m128i texY = _mm_and_si128(_mm_unpacklo_epi64(ty0, ty1), texMask);
+        __m128i inside = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(cellX, minusOne), _mm_cmplt_epi32(cellX, widthv)),
+                                       _mm_and_si128(_mm_cmpgt_epi32(cellY, minusOne), _mm_cmplt_epi32(cellY, heightv)));
+        __m128i texOffset = _mm_or_si128(_mm_sll_epi32(texY, rowShift), texX);
+
+        int32_t cellXs[4];
+        int32_t cellYs[4];
+        int32_t offsets[4];
+        int32_t masks[4];
+        _mm_storeu_si128((__m128i *)cellXs, cellX);
+        _mm_storeu_si128((__m128i *)cellYs, cellY);
+        _mm_storeu_si128((__m128i *)offsets, texOffset);
+        _mm_storeu_si128((__m128i *)masks, inside);
+        for (int i = 0; i < 4; ++i) {
+            uint32_t color = FLOOR_VOID_COLOR;
+            if (masks[i]) {
+                int material = floor_materials[cellYs[i] * width + cellXs[i]];
+                color = texels[(material << level->textureShift) | offsets[i]];
+            }
+            dst[x + i] = color;
+        }
+    }
+    floor_span_range(dst, x, count, floorX, floorY, stepX, stepY, level);
+}
+
+__attribute__((target("avx2")))
+static __m256i floor_cvtt_pair(__m256d lo, __m256d hi) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm256_cvttpd_epi32(lo)), _mm256_cvttpd_epi32(hi), 1);
+}
+
+__attribute__((target("avx2")))
+static __m256d floor_frac_scaled(__m256d pos, __m128i cell, __m256d texScale) {
+    return _mm256_mul_pd(_mm256_sub_pd(pos, _mm256_cvtepi32_pd(cell)), texScale);
+}
+
+// 8 pixels per iteration with gathered material and texel fetches
+__attribute__((target("avx2")))
+static void floor_span_avx2(uint32_t *dst, int count, double floorX, double floorY, double stepX,
+                            double stepY, const FloorLevel *level) {
+    const int *texels = (const int *)level->texels;
+    const int *materials = (const int *)floor_materials;
+    const __m256d baseX = _mm256_set1_pd(floorX);
+    const __m256d baseY = _mm256_set1_pd(floorY);
+    const __m256d stepXv = _mm256_set1_pd(stepX);
+    const __m256d stepYv = _mm256_set1_pd(stepY);
+    const __m256d lanes = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d texScale = _mm256_set1_pd((double)level->size);
+    const __m256i texMask = _mm256_set1_epi32(level->size - 1);
+    const __m128i rowShift = _mm_cvtsi32_si128(level->rowShift);
+    const __m128i textureShift = _mm_cvtsi32_si128(level->textureShift);
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i widthv = _mm256_set1_epi32(floor_materials_width);
+    const __m256i heightv = _mm256_set1_epi32(floor_materials_height);
+    const __m256i minusOne = _mm256_set1_epi32(-1);
+    const __m256i voidColor = _mm256_set1_epi32((int)FLOOR_VOID_COLOR);
+
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m256d xs0 = _mm256_add_pd(_mm256_set1_pd((double)x), lanes);
+        __m256d xs1 = _mm256_add_pd(xs0, four);
+        __m256d fx0 = _mm256_add_pd(baseX, _mm256_mul_pd(xs0, stepXv));
+        __m256d fx1 = _mm256_add_pd(baseX, _mm256_mul_pd(xs1, stepXv));
+        __m256d fy0 = _mm256_add_pd(baseY, _mm256_mul_pd(xs0, stepYv));
+        __m256d fy1 = _mm256_add_pd(baseY, _mm256_mul_pd(xs1, stepYv));
+
+        __m128i cx0 = _mm256_cvttpd_epi32(fx0);
+        __m128i cx1 = _mm256_cvttpd_epi32(fx1);
+        __m128i cy0 = _mm256_cvttpd_epi32(fy0);
+        __m128i cy1 = _mm256_cvttpd_epi32(fy1);
+        __m256i cellX = _mm256_inserti128_si256(_mm256_castsi128_si256(cx0), cx1, 1);
+        __m256i cellY = _mm256_inserti128_si256(_mm256_castsi128_si256(cy0), cy1, 1);
+        __m256i texX = _mm256_and_si256(
+            floor_cvtt_pair(floor_frac_scaled(fx0, cx0, texScale), floor_frac_scaled(fx1, cx1, texScale)), texMask);
+        __m256i texY = _mm256_and_si256(
+            floor_cvtt_pair(floor_frac_scaled(fy0, cy0, texScale), floor_frac_scaled(fy1, cy1, texScale)), texMask);
+
+        __m256i inside = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpgt_epi32(cellX, minusOne), _mm256_cmpgt_epi32(widthv, cellX)),
+            _mm256_and_si256(_mm256_cmpgt_epi32(cellY, minusOne), _mm256_cmpgt_epi32(heightv, cellY)));
+        __m256i cellIndex = _mm256_and_si256(_mm256_add_epi32(_mm256_mullo_epi32(cellY, widthv), cellX), inside);
+
+        __m256i material = _mm256_and_si256(_mm256_i32gather_epi32(materials, cellIndex, 1), byteMask);
+        __m256i texelIndex = _mm256_or_si256(_mm256_sll_epi32(material, textureShift),
+                                             _mm256_or_si256(_mm256_sll_epi32(texY, rowShift), texX));
+        __m256i color = _mm256_i32gather_epi32(texels, texelIndex, 4);
+        color = _mm256_blendv_epi8(voidColor, color, inside);
+        _mm256_storeu_si256((__m256i *)(dst + x), color);
+    }
+    floor_span_range(dst, x, count, floorX, floorY, stepX, stepY, level);
+}
+#endif
+
+static void select_floor_kernel(void) {
+    floor_span_func = floor_span_scalar;
+    floor_span_name = "scalar";
+#if FLOORCAST_X86
+    const char *requested = getenv("TSS_FLOOR_KERNEL");
+    bool allow_avx2 = !requested || strcmp(requested, "avx2") == 0;
+    bool allow_sse2 = !requested || strcmp(requested, "scalar") != 0;
+    __builtin_cpu_init();
+    if (allow_avx2 && __builtin_cpu_supports("avx2")) {
+        floor_span_func = floor_span_avx2;
+        floor_span_name = "avx2";
+    } else if (allow_sse2) {
+        floor_span_func = floor_span_sse2;
+        floor_span_name = "sse2";
+    }
+#endif
+#if DEBUG_MODE
+    printf("[DEBUG] floorcast: using %s floor kernel\n", floor_span_name);
+#endif
+}
+
+const char *floorcast_kernel_name(void) {
+    return floor_span_name;
+}
+
+void floorcast_span(uint32_t *dst, int count, double floorX, double floorY, double stepX, double stepY, int level) {
+    if (!floor_materials || !floor_span_func || !floor_mips.levels[0]) {
+        for (int x = 0; x < count; ++x) {
+            dst[x] = FLOOR_VOID_COLOR;
+        }
+        return;
+    }
+    level = level < 0 ? 0 : (level >= TEX_MIP_LEVELS ? TEX_MIP_LEVELS - 1 : level);
+    FloorLevel mip = {floor_mips.levels[level], TEX_SIZE >> level, FLOOR_TEX_ROW_SHIFT - level,
+                      FLOOR_TEX_SHIFT - 2 * level};
+    floor_span_func(dst, count, floorX, floorY, stepX, stepY, &mip);
+}
@@ -0,0 +1,22 @@
+#ifndef FLOORCAST_H
+#define FLOORCAST_H
+
+#include "types.h"
+#include <stdint.h>
+
+// Floor texel for rays that leave the map
+#define FLOOR_VOID_COLOR PACK_COLOR_LITERAL(50, 40, 30)
+
+// Pick the span kernel on first use and rebuild the per-cell floor material table
+// if the map changed. Must run before floorcast_span each frame (not thread safe).
+void floorcast_prepare(const Map *map);
+
+// Fill count pixels of one floor row; pixel x samples world position
+// (floorX + x * stepX, floorY + x * stepY) from mip level of the floor
+// textures. Uses AVX2 or SSE2 when available.
+void floorcast_span(uint32_t *dst, int count, double floorX, double floorY, double stepX, double stepY, int level);
+
+// Name of the kernel floorcast_span dispatches to ("avx2", "sse2" or "scalar")
+const char *floorcast_kernel_name(void);
+
+#endif // FLOORCAST_H
@@ -0,0 +1,83 @@
+// Frame pacing: frame cap, vsync choice and idle waiting for the main loop
+#include "framepace.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// (Uint32)-1 until frame_pacer_init registers it; wakes before then are dropped
+static atomic_uint wake_event = (Uint32)-1;
+static atomic_bool wake_pending = false;
+
+int frame_pacer_default_fps(void) {
+    const char *env = getenv("TSS_FPS");
+    if (env && *env) {
+        int requested = atoi(env);
+        if (requested >= 0) {
+            return requested > FRAME_PACER_MAX_FPS ? FRAME_PACER_MAX_FPS : requested;
+        }
+    }
+    return FRAME_PACER_DEFAULT_FPS;
+}
+
+bool frame_pacer_default_vsync(void) {
+    const char *env = getenv("TSS_VSYNC");
+    return !(env && *env && atoi(env) == 0);
+}
+
+void frame_pacer_init(FramePacer *pacer, int target_fps) {
+    pacer->target_fps = target_fps > 0 ? target_fps : 0;
+    pacer->frame_ticks = pacer->target_fps ? SDL_GetPerformanceFrequency() / (uint64_t)pacer->target_fps : 0;
+    pacer->next_frame = 0;
+    if (atomic_load(&wake_event) == (Uint32)-1) {
+        atomic_store(&wake_event, SDL_RegisterEvents(1));
+    }
+}
+
+void frame_pacer_begin_frame(void) {
+    atomic_store(&wake_pending, false);
+}
+
+void frame_pacer_end_frame(FramePacer *pacer) {
+    if (!pacer->frame_ticks) {
+        return;
+    }
+    uint64_t now = SDL_GetPerformanceCounter();
+    if (!pacer->next_frame || now >= pacer->next_frame + pacer->frame_ticks) {
+        // First frame, or more than a frame behind: restart the schedule
+        // rather than rushing out frames to catch up
+        pacer->next_frame = now + pacer->frame_ticks;
+        return;
+    }
+    if (now < pacer->next_frame) {
+        uint64_t ms = (pacer->next_frame - now) * 1000 / SDL_GetPerformanceFrequency();
+        if (ms > 0) {
+            SDL_Delay((Uint32)ms);
+        }
+    }
+    // Deadlines advance by whole frames so sleep rounding doesn't accumulate
+    pacer->next_frame += pacer->frame_ticks;
+}
+
+void frame_pacer_idle(FramePacer *pacer, int timeout_ms) {
+    if (timeout_ms < 0) {
+        SDL_WaitEvent(NULL);
+    } else {
+        SDL_WaitEventTimeout(NULL, timeout_ms);
+    }
+    pacer->next_frame = 0;  // The frame that follows starts a fresh schedule
+}
+
+void frame_pacer_wake(void) {
+    Uint32 type = atomic_load(&wake_event);
+    if (type == (Uint32)-1 || atomic_exchange(&wake_pending, true)) {
+        return;
+    }
+    SDL_Event event;
+    memset(&event, 0, sizeof(event));
+    event.type = type;
+    SDL_PushEvent(&event);
+}
+
+bool frame_pacer_is_wake(const SDL_Event *event) {
+    return event->type == atomic_load(&wake_event);
+}
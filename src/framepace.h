@@ -0,0 +1,44 @@
+#ifndef FRAMEPACE_H
+#define FRAMEPACE_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FRAME_PACER_DEFAULT_FPS 60
+#define FRAME_PACER_MAX_FPS 1000
+
+typedef struct {
+    int target_fps;       // 0 = uncapped
+    uint64_t frame_ticks; // Performance-counter ticks per frame
+    uint64_t next_frame;  // Counter value the next frame is due at, 0 = unscheduled
+} FramePacer;
+
+// Frame cap from TSS_FPS (0 = uncapped), FRAME_PACER_DEFAULT_FPS if unset
+int frame_pacer_default_fps(void);
+
+// Present in step with the display unless TSS_VSYNC=0
+bool frame_pacer_default_vsync(void);
+
+// Also registers the wake event, so call it after SDL_Init
+void frame_pacer_init(FramePacer *pacer, int target_fps);
+
+// Call at the top of each loop iteration, before reading what may change.
+// Wakes requested from then on are guaranteed to interrupt frame_pacer_idle.
+void frame_pacer_begin_frame(void);
+
+// Sleep out the rest of the frame after presenting
+void frame_pacer_end_frame(FramePacer *pacer);
+
+// Nothing to draw: block until an SDL event arrives or timeout_ms passes
+// (-1 waits indefinitely). The event stays queued for SDL_PollEvent.
+void frame_pacer_idle(FramePacer *pacer, int timeout_ms);
+
+// Wake the main thread out of frame_pacer_idle. Safe from any thread; calls
+// between two frames queue a single event.
+void frame_pacer_wake(void);
+
+// True for the event frame_pacer_wake queues, which carries no input
+bool frame_pacer_is_wake(const SDL_Event *event);
+
+#endif // FRAMEPACE_H
@@ -52,6 +52,7 @@ void game_free_game_maps(Game *game) {
 void game_reset_state(Game *game) {
     game->hud_message[0] = '\0';
     game->hud_message_timer = 0.0;
+    game->world_version++;
     if (game->door_state) {
         for (int y = 0; y < game->map.height; ++y) {
             for (int x = 0; x < game->map.width; ++x) {
@@ -157,7 +158,9 @@ void game_update_hud_bob(Game *game, bool moving, double delta) {
     if (game->hud_bob_phase > M_PI * 2.0) {
         game->hud_bob_phase = fmod(game->hud_bob_phase, M_PI * 2.0);
     }
-    double amplitude = moving ? 14.0 : 2.0;
+    // Standing still the HUD settles rather than swaying, so an idle scene
+    // stops changing and the main loop can sleep
+    double amplitude = moving ? 14.0 : 0.0;
     double desired = sin(game->hud_bob_phase) * amplitude;
     double response = moving ? 8.0 : 4.0;
     double t = delta * response;
@@ -165,6 +168,15 @@ void game_update_hud_bob(Game *game, bool moving, double delta) {
         t = 1.0;
     }
     game->hud_bob_offset += (desired - game->hud_bob_offset) * t;
+    if (!moving && fabs(game->hud_bob_offset) < 1.0) {
+        // Drawn in whole pixels, so this is already at rest on screen
+        game->hud_bob_offset = 0.0;
+        game->hud_bob_phase = 0.0;
+    }
+}
+
+bool game_hud_bob_settled(const Game *game) {
+    return game->hud_bob_offset == 0.0;
 }
 
 void set_hud_message(Game *game, const char *msg) {
@@ -188,11 +200,9 @@ void game_init_terminals(Game *game) {
 }
 
 void game_cleanup_terminals(Game *game) {
-    // Close all active terminals
+    // Close all active terminals and free their grids
     for (int i = 0; i < MAX_TERMINALS; i++) {
-        if (game->terminals[i].active) {
-            terminal_close(&game->terminals[i]);
-        }
+        terminal_destroy(&game->terminals[i]);
     }
     game->terminal_mode = false;
     game->active_terminal = -1;
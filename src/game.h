@@ -11,6 +11,7 @@ void game_reset_state(Game *game);
 void game_pick_spawn(Game *game);
 void game_update_hud_status(Game *game);
 void game_update_hud_bob(Game *game, bool moving, double delta);
+bool game_hud_bob_settled(const Game *game);
 
 // HUD message functions
 void set_hud_message(Game *game, const char *msg);
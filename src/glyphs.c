@@ -0,0 +1,310 @@
+// Glyph cache: font8x8_basic extended with Latin-1, box drawing and blocks
+#include "glyphs.h"
+#include "../include/font8x8_basic.h"
+#include "../include/font8x8_latin1.h"
+#include <stdbool.h>
+#include <string.h>
+
+static unsigned char glyph_cache[GLYPH_COUNT][8];
+static bool glyph_built[GLYPH_COUNT];
+
+// Replacement box ("tofu") for characters without a glyph
+static const unsigned char glyph_tofu[8] = {0x00, 0x3f, 0x21, 0x21, 0x21, 0x21, 0x3f, 0x00};
+
+// Accents are two rows drawn above the letter
+enum { GRAVE, ACUTE, CIRCUMFLEX, TILDE, DIAERESIS, RING, CEDILLA };
+static const unsigned char accent_rows[][2] = {
+    [GRAVE] = {0x06, 0x0c},
+    [ACUTE] = {0x18, 0x0c},
+    [CIRCUMFLEX] = {0x0c, 0x12},
+    [TILDE] = {0x16, 0x0d},
+    [DIAERESIS] = {0x33, 0x00},
+    [RING] = {0x1e, 0x12},
+};
+
+// Accented letters in U+00C0-U+00FF as base letter + accent; base 0 means
+// the glyph is drawn in font8x8_latin1 instead
+static const struct {
+    char base;
+    unsigned char accent;
+} latin1_letters[64] = {
+    {'A', GRAVE}, {'A', ACUTE}, {'A', CIRCUMFLEX}, {'A', TILDE}, {'A', DIAERESIS}, {'A', RING}, {0, 0}, {'C', CEDILLA},
+    {'E', GRAVE}, {'E', ACUTE}, {'E', CIRCUMFLEX}, {'E', DIAERESIS}, {'I', GRAVE}, {'I', ACUTE}, {'I', CIRCUMFLEX}, {'I', DIAERESIS},
+    {0, 0}, {'N', TILDE}, {'O', GRAVE}, {'O', ACUTE}, {'O', CIRCUMFLEX}, {'O', TILDE}, {'O', DIAERESIS}, {0, 0},
+    {0, 0}, {'U', GRAVE}, {'U', ACUTE}, {'U', CIRCUMFLEX}, {'U', DIAERESIS}, {'Y', ACUTE}, {0, 0}, {0, 0},
+    {'a', GRAVE}, {'a', ACUTE}, {'a', CIRCUMFLEX}, {'a', TILDE}, {'a', DIAERESIS}, {'a', RING}, {0, 0}, {'c', CEDILLA},
+    {'e', GRAVE}, {'e', ACUTE}, {'e', CIRCUMFLEX}, {'e', DIAERESIS}, {'i', GRAVE}, {'i', ACUTE}, {'i', CIRCUMFLEX}, {'i', DIAERESIS},
+    {0, 0}, {'n', TILDE}, {'o', GRAVE}, {'o', ACUTE}, {'o', CIRCUMFLEX}, {'o', TILDE}, {'o', DIAERESIS}, {0, 0},
+    {0, 0}, {'u', GRAVE}, {'u', ACUTE}, {'u', CIRCUMFLEX}, {'u', DIAERESIS}, {'y', ACUTE}, {0, 0}, {'y', DIAERESIS},
+};
+
+static void build_accented(unsigned char *out, char base, int accent) {
+    const unsigned char *letter = font8x8_basic[(unsigned char)base];
+    if (accent == CEDILLA) {
+        memcpy(out, letter, 8);
+        out[7] |= 0x0c;
+        return;
+    }
+    if (base >= 'A' && base <= 'Z') {
+        // Capitals fill rows 0-6: squeeze out the row most like its
+        // neighbour so the letter fits in rows 2-7 under the accent
+        int drop = 1;
+        int best = 9;
+        for (int y = 1; y < 7; y++) {
+            int diff = 0;
+            for (unsigned bits = letter[y] ^ letter[y - 1]; bits; bits &= bits - 1) {
+                diff++;
+            }
+            if (diff < best) {
+                best = diff;
+                drop = y;
+            }
+        }
+        int dst = 2;
+        for (int y = 0; y < 7; y++) {
+            if (y != drop) {
+                out[dst++] = letter[y];
+            }
+        }
+    } else {
+        // Lowercase letters start at row 2 (this also drops the dot of i)
+        memcpy(out, letter, 8);
+    }
+    out[0] = accent_rows[accent][0];
+    out[1] = accent_rows[accent][1];
+}
+
+// Box drawing arms: 2 bits each for up, right, down and left
+enum { NONE, LIGHT, HEAVY, DOUBLE };
+#define ARMS(u, r, d, l) ((u) | ((r) << 2) | ((d) << 4) | ((l) << 6))
+#define L LIGHT
+#define H HEAVY
+#define D DOUBLE
+static const unsigned char box_arms[0x80] = {
+    // U+2500: lines and dashes
+    ARMS(0, L, 0, L), ARMS(0, H, 0, H), ARMS(L, 0, L, 0), ARMS(H, 0, H, 0),
+    ARMS(0, L, 0, L), ARMS(0, H, 0, H), ARMS(L, 0, L, 0), ARMS(H, 0, H, 0),
+    ARMS(0, L, 0, L), ARMS(0, H, 0, H), ARMS(L, 0, L, 0), ARMS(H, 0, H, 0),
+    // U+250C: corners
+    ARMS(0, L, L, 0), ARMS(0, H, L, 0), ARMS(0, L, H, 0), ARMS(0, H, H, 0),
+    ARMS(0, 0, L, L), ARMS(0, 0, L, H), ARMS(0, 0, H, L), ARMS(0, 0, H, H),
+    ARMS(L, L, 0, 0), ARMS(L, H, 0, 0), ARMS(H, L, 0, 0), ARMS(H, H, 0, 0),
+    ARMS(L, 0, 0, L), ARMS(L, 0, 0, H), ARMS(H, 0, 0, L), ARMS(H, 0, 0, H),
+    // U+251C: tees
+    ARMS(L, L, L, 0), ARMS(L, H, L, 0), ARMS(H, L, L, 0), ARMS(L, L, H, 0),
+    ARMS(H, L, H, 0), ARMS(H, H, L, 0), ARMS(L, H, H, 0), ARMS(H, H, H, 0),
+    ARMS(L, 0, L, L), ARMS(L, 0, L, H), ARMS(H, 0, L, L), ARMS(L, 0, H, L),
+    ARMS(H, 0, H, L), ARMS(H, 0, L, H), ARMS(L, 0, H, H), ARMS(H, 0, H, H),
+    ARMS(0, L, L, L), ARMS(0, L, L, H), ARMS(0, H, L, L), ARMS(0, H, L, H),
+    ARMS(0, L, H, L), ARMS(0, L, H, H), ARMS(0, H, H, L), ARMS(0, H, H, H),
+    ARMS(L, L, 0, L), ARMS(L, L, 0, H), ARMS(L, H, 0, L), ARMS(L, H, 0, H),
+    ARMS(H, L, 0, L), ARMS(H, L, 0, H), ARMS(H, H, 0, L), ARMS(H, H, 0, H),
+    // U+253C: crosses
+    ARMS(L, L, L, L), ARMS(L, L, L, H), ARMS(L, H, L, L), ARMS(L, H, L, H),
+    ARMS(H, L, L, L), ARMS(L, L, H, L), ARMS(H, L, H, L), ARMS(H, L, L, H),
+    ARMS(H, H, L, L), ARMS(L, L, H, H), ARMS(L, H, H, L), ARMS(H, H, L, H),
+    ARMS(L, H, H, H), ARMS(H, L, H, H), ARMS(H, H, H, L), ARMS(H, H, H, H),
+    // U+254C: double dashes
+    ARMS(0, L, 0, L), ARMS(0, H, 0, H), ARMS(L, 0, L, 0), ARMS(H, 0, H, 0),
+    // U+2550: double lines
+    ARMS(0, D, 0, D), ARMS(D, 0, D, 0), ARMS(0, D, L, 0), ARMS(0, L, D, 0),
+    ARMS(0, D, D, 0), ARMS(0, 0, L, D), ARMS(0, 0, D, L), ARMS(0, 0, D, D),
+    ARMS(L, D, 0, 0), ARMS(D, L, 0, 0), ARMS(D, D, 0, 0), ARMS(L, 0, 0, D),
+    ARMS(D, 0, 0, L), ARMS(D, 0, 0, D), ARMS(L, D, L, 0), ARMS(D, L, D, 0),
+    ARMS(D, D, D, 0), ARMS(L, 0, L, D), ARMS(D, 0, D, L), ARMS(D, 0, D, D),
+    ARMS(0, D, L, D), ARMS(0, L, D, L), ARMS(0, D, D, D), ARMS(L, D, 0, D),
+    ARMS(D, L, 0, L), ARMS(D, D, 0, D), ARMS(L, D, L, D), ARMS(D, L, D, L),
+    ARMS(D, D, D, D),
+    // U+256D: arcs, then diagonals (drawn separately)
+    ARMS(0, L, L, 0), ARMS(0, 0, L, L), ARMS(L, 0, 0, L), ARMS(L, L, 0, 0),
+    0, 0, 0,
+    // U+2574: half lines
+    ARMS(0, 0, 0, L), ARMS(L, 0, 0, 0), ARMS(0, L, 0, 0), ARMS(0, 0, L, 0),
+    ARMS(0, 0, 0, H), ARMS(H, 0, 0, 0), ARMS(0, H, 0, 0), ARMS(0, 0, H, 0),
+    ARMS(0, H, 0, L), ARMS(L, 0, H, 0), ARMS(0, L, 0, H), ARMS(H, 0, L, 0),
+};
+#undef L
+#undef H
+#undef D
+
+enum { ARM_UP, ARM_RIGHT, ARM_DOWN, ARM_LEFT };
+
+// Positions across the arm of its one or two parallel lines
+static int arm_lines(int weight, int *lines) {
+    switch (weight) {
+        case LIGHT: lines[0] = 3; return 1;
+        case HEAVY: lines[0] = 3; lines[1] = 4; return 2;
+        case DOUBLE: lines[0] = 2; lines[1] = 5; return 2;
+        default: return 0;
+    }
+}
+
+// How far toward the far edge a line of an arm reaches so it meets the
+// perpendicular arms: "toward" is the arm's own edge (down/right = 7)
+static int arm_reach(const int *weight, int arm, int line) {
+    bool toward_high = (arm == ARM_DOWN || arm == ARM_RIGHT);
+    int side_a = (arm == ARM_UP || arm == ARM_DOWN) ? ARM_LEFT : ARM_UP;
+    int side_b = side_a == ARM_LEFT ? ARM_RIGHT : ARM_DOWN;
+    int lines_a[2], lines_b[2];
+    int count_a = arm_lines(weight[side_a], lines_a);
+    int count_b = arm_lines(weight[side_b], lines_b);
+
+    // near = the perpendicular line closest to this arm's edge, far = furthest
+    int near = toward_high ? 0 : 7;
+    int far = toward_high ? 7 : 0;
+    const int *lists[2] = {lines_a, lines_b};
+    int counts[2] = {count_a, count_b};
+    int use = -1;  // -1: both perpendicular arms
+    if (weight[arm] == DOUBLE) {
+        // Each line of a double arm only joins the perpendicular on its side
+        int side = line < 4 ? 0 : 1;
+        if (counts[side]) {
+            use = side;
+        }
+    }
+    for (int s = 0; s < 2; s++) {
+        if (use >= 0 && s != use) {
+            continue;
+        }
+        for (int i = 0; i < counts[s]; i++) {
+            int p = lists[s][i];
+            if (toward_high ? p > near : p < near) near = p;
+            if (toward_high ? p < far : p > far) far = p;
+        }
+    }
+    if (count_a == 0 && count_b == 0) {
+        return toward_high ? 3 : 4;
+    }
+    // A line stops at the near side of a tee (or the matching side of a
+    // double); past a corner, or straight through a crossing, it reaches the
+    // far side
+    int opposite = (arm + 2) % 4;
+    if (use >= 0 || (count_a && count_b && weight[opposite] == NONE)) {
+        return near;
+    }
+    return far;
+}
+
+static void set_pixel(unsigned char *out, int x, int y) {
+    out[y] |= (unsigned char)(1u << x);
+}
+
+static void build_box(unsigned char *out, uint32_t ch) {
+    int offset = (int)(ch - GLYPH_BOX_FIRST);
+    if (ch >= 0x2571 && ch <= 0x2573) {
+        for (int i = 0; i < 8; i++) {
+            if (ch != 0x2572) set_pixel(out, 7 - i, i);
+            if (ch != 0x2571) set_pixel(out, i, i);
+        }
+        return;
+    }
+
+    int weight[4];
+    for (int arm = 0; arm < 4; arm++) {
+        weight[arm] = (box_arms[offset] >> (arm * 2)) & 3;
+    }
+    for (int arm = 0; arm < 4; arm++) {
+        int lines[2];
+        int count = arm_lines(weight[arm], lines);
+        for (int i = 0; i < count; i++) {
+            int reach = arm_reach(weight, arm, lines[i]);
+            int from = (arm == ARM_UP || arm == ARM_LEFT) ? 0 : reach;
+            int to = (arm == ARM_UP || arm == ARM_LEFT) ? reach : 7;
+            for (int p = from; p <= to; p++) {
+                if (arm == ARM_UP || arm == ARM_DOWN) {
+                    set_pixel(out, lines[i], p);
+                } else {
+                    set_pixel(out, p, lines[i]);
+                }
+            }
+        }
+    }
+
+    // Dashed lines keep every other segment of the solid one
+    unsigned char dashes = 0;
+    if (ch >= 0x2504 && ch <= 0x2507) dashes = 0xdb;
+    if (ch >= 0x2508 && ch <= 0x250b) dashes = 0x55;
+    if (ch >= 0x254c && ch <= 0x254f) dashes = 0x77;
+    if (dashes) {
+        bool vertical = weight[ARM_UP] != NONE;
+        for (int y = 0; y < 8; y++) {
+            out[y] &= vertical ? ((dashes >> y) & 1 ? 0xff : 0x00) : dashes;
+        }
+    }
+    // Arcs: drop the corner pixel so the turn reads as rounded
+    if (ch >= 0x256d && ch <= 0x2570) {
+        out[3] &= (unsigned char)~(1u << 3);
+    }
+}
+
+static void fill_rect(unsigned char *out, int x0, int y0, int x1, int y1) {
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            set_pixel(out, x, y);
+        }
+    }
+}
+
+// U+2580-U+259F: eighths, halves, shades and quadrants
+static void build_block(unsigned char *out, uint32_t ch) {
+    if (ch == 0x2580) {
+        fill_rect(out, 0, 0, 8, 4);
+    } else if (ch <= 0x2588) {
+        fill_rect(out, 0, 8 - (int)(ch - 0x2580), 8, 8);  // Lower eighths
+    } else if (ch <= 0x258f) {
+        fill_rect(out, 0, 0, 8 - (int)(ch - 0x2588), 8);  // Left eighths
+    } else if (ch == 0x2590) {
+        fill_rect(out, 4, 0, 8, 8);
+    } else if (ch <= 0x2593) {
+        static const unsigned char shades[3][2] = {{0x88, 0x22}, {0xaa, 0x55}, {0x77, 0xdd}};
+        for (int y = 0; y < 8; y++) {
+            out[y] = shades[ch - 0x2591][y & 1];
+        }
+    } else if (ch == 0x2594) {
+        fill_rect(out, 0, 0, 8, 1);
+    } else if (ch == 0x2595) {
+        fill_rect(out, 7, 0, 8, 8);
+    } else {
+        // Quadrants, bit 0-3 = upper left, upper right, lower left, lower right
+        static const unsigned char quadrants[10] = {0x4, 0x8, 0x1, 0xd, 0x9, 0x7, 0xb, 0x2, 0x6, 0xe};
+        unsigned char q = quadrants[ch - 0x2596];
+        if (q & 1) fill_rect(out, 0, 0, 4, 4);
+        if (q & 2) fill_rect(out, 4, 0, 8, 4);
+        if (q & 4) fill_rect(out, 0, 4, 4, 8);
+        if (q & 8) fill_rect(out, 4, 4, 8, 8);
+    }
+}
+
+static void build_glyph(unsigned char *out, int index) {
+    memset(out, 0, 8);
+    if (index < 0x80) {
+        memcpy(out, font8x8_basic[index], 8);
+    } else if (index < GLYPH_LATIN1_COUNT) {
+        int letter = index - 0xC0;
+        if (letter >= 0 && latin1_letters[letter].base) {
+            build_accented(out, latin1_letters[letter].base, latin1_letters[letter].accent);
+        } else if (index >= 0xA0) {
+            memcpy(out, font8x8_latin1[index - 0xA0], 8);
+        }
+    } else if (index < GLYPH_REPLACEMENT) {
+        uint32_t ch = GLYPH_BOX_FIRST + (uint32_t)(index - GLYPH_LATIN1_COUNT);
+        if (ch < 0x2580) {
+            build_box(out, ch);
+        } else {
+            build_block(out, ch);
+        }
+    } else {
+        memcpy(out, glyph_tofu, 8);
+    }
+}
+
+const unsigned char *glyph_bitmap(int index) {
+    if (index < 0 || index >= GLYPH_COUNT) {
+        index = GLYPH_REPLACEMENT;
+    }
+    if (!glyph_built[index]) {
+        build_glyph(glyph_cache[index], index);
+        glyph_built[index] = true;
+    }
+    return glyph_cache[index];
+}
@@ -0,0 +1,29 @@
+#ifndef GLYPHS_H
+#define GLYPHS_H
+
+#include <stdint.h>
+
+// Glyph slots: Latin-1 (U+0000-U+00FF), box drawing and block elements
+// (U+2500-U+259F), then a replacement box for everything else
+#define GLYPH_LATIN1_COUNT 0x100
+#define GLYPH_BOX_FIRST 0x2500
+#define GLYPH_BOX_COUNT 0xA0
+#define GLYPH_REPLACEMENT (GLYPH_LATIN1_COUNT + GLYPH_BOX_COUNT)
+#define GLYPH_COUNT (GLYPH_REPLACEMENT + 1)
+
+// Slot for a codepoint; control characters map to the blank glyph
+static inline int glyph_index(uint32_t ch) {
+    if (ch < GLYPH_LATIN1_COUNT) {
+        return (ch < 32 || (ch >= 127 && ch < 0xA0)) ? ' ' : (int)ch;
+    }
+    if (ch - GLYPH_BOX_FIRST < GLYPH_BOX_COUNT) {
+        return GLYPH_LATIN1_COUNT + (int)(ch - GLYPH_BOX_FIRST);
+    }
+    return GLYPH_REPLACEMENT;
+}
+
+// 8x8 bitmap in font8x8_basic layout (one byte per row, bit N = column N),
+// built on first use. Only the main thread draws text, so no locking.
+const unsigned char *glyph_bitmap(int index);
+
+#endif // GLYPHS_H
@@ -0,0 +1,143 @@
+// Persistent worker pool used to split render passes into tiles
+#define _POSIX_C_SOURCE 200809L
+#include "jobs.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct JobPool {
+    pthread_t threads[MAX_JOB_THREADS];
+    int worker_count;      // Threads spawned (caller thread not included)
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    JobFunc func;
+    void *ctx;
+    int job_count;
+    int next_job;
+    int jobs_remaining;
+    bool shutting_down;
+};
+
+// Pull jobs until the current batch is exhausted. Called with the lock held.
+static void job_pool_drain(JobPool *pool) {
+    while (pool->next_job < pool->job_count) {
+        int index = pool->next_job++;
+        JobFunc func = pool->func;
+        void *ctx = pool->ctx;
+        pthread_mutex_unlock(&pool->lock);
+        func(ctx, index);
+        pthread_mutex_lock(&pool->lock);
+        pool->jobs_remaining--;
+        if (pool->jobs_remaining == 0) {
+            pthread_cond_broadcast(&pool->work_done);
+        }
+    }
+}
+
+static void *job_pool_worker(void *arg) {
+    JobPool *pool = (JobPool *)arg;
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->shutting_down) {
+        if (pool->next_job >= pool->job_count) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+            continue;
+        }
+        job_pool_drain(pool);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+JobPool *job_pool_create(int thread_count) {
+    if (thread_count < 1) {
+        thread_count = 1;
+    }
+    if (thread_count > MAX_JOB_THREADS) {
+        thread_count = MAX_JOB_THREADS;
+    }
+
+    JobPool *pool = (JobPool *)calloc(1, sizeof(JobPool));
+    if (!pool) {
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    for (int i = 0; i < thread_count - 1; ++i) {
+        if (pthread_create(&pool->threads[i], NULL, job_pool_worker, pool) != 0) {
+            fprintf(stderr, "job_pool_create: only started %d of %d workers\n", i, thread_count - 1);
+            break;
+        }
+        pool->worker_count++;
+    }
+    return pool;
+}
+
+void job_pool_destroy(JobPool *pool) {
+    if (!pool) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->shutting_down = true;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->worker_count; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->work_done);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+int job_pool_thread_count(const JobPool *pool) {
+    return pool ? pool->worker_count + 1 : 1;
+}
+
+void job_pool_run(JobPool *pool, JobFunc func, void *ctx, int count) {
+    if (!func || count <= 0) {
+        return;
+    }
+    if (!pool || pool->worker_count == 0 || count == 1) {
+        for (int i = 0; i < count; ++i) {
+            func(ctx, i);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->func = func;
+    pool->ctx = ctx;
+    pool->job_count = count;
+    pool->next_job = 0;
+    pool->jobs_remaining = count;
+    pthread_cond_broadcast(&pool->work_ready);
+
+    // The caller works on the batch too instead of idling until it completes
+    job_pool_drain(pool);
+    while (pool->jobs_remaining > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pool->job_count = 0;
+    pool->next_job = 0;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int job_pool_default_threads(void) {
+    const char *env = getenv("TSS_RENDER_THREADS");
+    if (env && *env) {
+        int requested = atoi(env);
+        if (requested >= 1) {
+            return requested > MAX_JOB_THREADS ? MAX_JOB_THREADS : requested;
+        }
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) {
+        cpus = 1;
+    }
+    return cpus > MAX_JOB_THREADS ? MAX_JOB_THREADS : (int)cpus;
+}
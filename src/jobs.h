@@ -0,0 +1,25 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stdbool.h>
+
+#define MAX_JOB_THREADS 32
+
+// Job callback: index runs from 0 to count-1 for each job_pool_run dispatch
+typedef void (*JobFunc)(void *ctx, int index);
+
+typedef struct JobPool JobPool;
+
+// Persistent worker pool; thread_count includes the calling thread
+JobPool *job_pool_create(int thread_count);
+void job_pool_destroy(JobPool *pool);
+int job_pool_thread_count(const JobPool *pool);
+
+// Run count jobs across the pool and block until all of them have finished.
+// A NULL pool (or a single-threaded one) runs the jobs inline, in order.
+void job_pool_run(JobPool *pool, JobFunc func, void *ctx, int count);
+
+// Thread count from TSS_RENDER_THREADS, falling back to the online CPU count
+int job_pool_default_threads(void);
+
+#endif // JOBS_H
@@ -8,6 +8,10 @@
 #include "cabinet.h"
 #include "display.h"
 #include "terminal.h"
+#include "ptyio.h"
+#include "framepace.h"
+#include "resolution.h"
+#include "profiler.h"
 #include "ui.h"
 #include <SDL2/SDL.h>
 #include <stdio.h>
@@ -16,10 +20,18 @@
 #include <math.h>
 #include <string.h>
 
+// How often an idle loop still polls the PTYs when no I/O thread reads them
+#define IDLE_POLL_MS 10
+
 typedef struct {
     SDL_Window *window;
     SDL_Renderer *renderer;
-    SDL_Texture *framebuffer;
+    SDL_Texture *framebuffer;     // HUD layer, or the whole screen in terminal mode
+    SDL_Texture *view;            // 3D view, at the renderer's view size
+    int view_width;
+    int view_height;
+    SDL_Texture *profiler_panel;  // Created the first time the overlay is shown
+    uint32_t *profiler_pixels;    // SCREEN_WIDTH x PROFILER_PANEL_HEIGHT
 } Video;
 
 static bool video_init(Video *video) {
@@ -27,19 +39,27 @@ static bool video_init(Video *video) {
         fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
         return false;
     }
-    video->window =
-        SDL_CreateWindow("tty-space-station", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, 0);
+    video->window = SDL_CreateWindow("tty-space-station", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                                     SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
     if (!video->window) {
         fprintf(stderr, "SDL_CreateWindow failed: %s\n", SDL_GetError());
         return false;
     }
-    video->renderer = SDL_CreateRenderer(video->window, -1, SDL_RENDERER_ACCELERATED);
+    SDL_SetWindowMinimumSize(video->window, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+    Uint32 flags = SDL_RENDERER_ACCELERATED;
+    if (frame_pacer_default_vsync()) {
+        flags |= SDL_RENDERER_PRESENTVSYNC;
+    }
+    video->renderer = SDL_CreateRenderer(video->window, -1, flags);
     if (!video->renderer) {
         fprintf(stderr, "SDL_CreateRenderer failed: %s\n", SDL_GetError());
         SDL_DestroyWindow(video->window);
         SDL_Quit();
         return false;
     }
+    // Everything is laid out at SCREEN_WIDTH x SCREEN_HEIGHT and scaled to the
+    // window, letterboxed; the 3D view texture supplies the real detail
+    SDL_RenderSetLogicalSize(video->renderer, SCREEN_WIDTH, SCREEN_HEIGHT);
     video->framebuffer =
         SDL_CreateTexture(video->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH,
                           SCREEN_HEIGHT);
@@ -53,7 +73,33 @@ static bool video_init(Video *video) {
     return true;
 }
 
+// Recreate the view texture when the renderer's view size changed. Returns
+// true when it did, so the view must be uploaded whether or not it was redrawn.
+static bool video_sync_view(Video *video, int width, int height) {
+    if (video->view && width == video->view_width && height == video->view_height) {
+        return false;
+    }
+    if (video->view) {
+        SDL_DestroyTexture(video->view);
+    }
+    video->view = SDL_CreateTexture(video->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width,
+                                    height);
+    if (!video->view) {
+        fprintf(stderr, "SDL_CreateTexture failed: %s\n", SDL_GetError());
+    }
+    video->view_width = width;
+    video->view_height = height;
+    return true;
+}
+
 static void video_destroy(Video *video) {
+    if (video->profiler_panel) {
+        SDL_DestroyTexture(video->profiler_panel);
+    }
+    free(video->profiler_pixels);
+    if (video->view) {
+        SDL_DestroyTexture(video->view);
+    }
     if (video->framebuffer) {
         SDL_DestroyTexture(video->framebuffer);
     }
@@ -66,6 +112,38 @@ static void video_destroy(Video *video) {
     SDL_Quit();
 }
 
+// The profiler panel has its own texture, copied over the frame, so it never
+// disturbs the framebuffer the scene and terminal views redraw incrementally
+static void video_draw_profiler(Video *video) {
+    if (!video->profiler_panel) {
+        video->profiler_pixels = calloc((size_t)SCREEN_WIDTH * PROFILER_PANEL_HEIGHT, sizeof(uint32_t));
+        video->profiler_panel = SDL_CreateTexture(video->renderer, SDL_PIXELFORMAT_ARGB8888,
+                                                  SDL_TEXTUREACCESS_STREAMING, PROFILER_PANEL_WIDTH,
+                                                  PROFILER_PANEL_HEIGHT);
+        if (!video->profiler_pixels || !video->profiler_panel) {
+            fprintf(stderr, "Profiler overlay unavailable: %s\n", SDL_GetError());
+            profiler_set_overlay(false);
+            return;
+        }
+    }
+    render_profiler_panel(video->profiler_pixels);
+    SDL_UpdateTexture(video->profiler_panel, NULL, video->profiler_pixels, SCREEN_WIDTH * sizeof(uint32_t));
+    SDL_Rect dst = {SCREEN_WIDTH - PROFILER_PANEL_WIDTH - 8, 8, PROFILER_PANEL_WIDTH, PROFILER_PANEL_HEIGHT};
+    SDL_RenderCopy(video->renderer, video->profiler_panel, NULL, &dst);
+}
+
+static void toggle_trace(Game *game) {
+    char msg[128];
+    if (!profiler_tracing()) {
+        set_hud_message(game, profiler_trace_start() ? "Recording trace. F3 to stop." : "Trace unavailable.");
+    } else if (profiler_trace_stop(profiler_trace_path())) {
+        snprintf(msg, sizeof(msg), "Trace written to %s", profiler_trace_path());
+        set_hud_message(game, msg);
+    } else {
+        set_hud_message(game, "Could not write trace.");
+    }
+}
+
 static void select_tool(Game *game, HudToolType tool) {
     if (!game || tool < 0 || tool >= NUM_HUD_TOOLS) {
         return;
@@ -95,6 +173,8 @@ static void select_tool(Game *game, HudToolType tool) {
 
 int main(void) {
     srand((unsigned)time(NULL));
+    // Before SDL or the render pool spawn threads, so SIGCHLD stays blocked in all of them
+    pty_io_init();
     Video video = {0};
     if (!video_init(&video)) {
         return EXIT_FAILURE;
@@ -107,18 +187,40 @@ int main(void) {
     generate_sky_texture();
     generate_display_texture();
     load_custom_textures();
+    build_texture_mips();
 
     Game game;
     game_init(&game);
+    FramePacer pacer;
+    frame_pacer_init(&pacer, frame_pacer_default_fps());
+    Resolution resolution;
+    resolution_init(&resolution, resolution_default_scale(), resolution_default_dynamic(), pacer.target_fps);
+
+    // Shell output is read and parsed off the render thread when possible;
+    // it wakes the main loop when there's something new to draw
+    pty_io_set_notify(frame_pacer_wake);
+    bool io_threaded = pty_io_start(game.terminals, MAX_TERMINALS);
 
     uint32_t *pixels = calloc(SCREEN_WIDTH * SCREEN_HEIGHT, sizeof(uint32_t));
-    double *zbuffer = malloc(sizeof(double) * SCREEN_WIDTH);
     bool running = true;
     uint64_t lastTicks = SDL_GetTicks64();
+    uint32_t last_output = 0;
+    bool redraw = true;
 
     while (running) {
+        frame_pacer_begin_frame();
+        uint64_t frame_start = profiler_begin();
+        uint64_t work_start = SDL_GetPerformanceCounter();
+        // Terminal spawns, closes and input happen under the PTY I/O lock;
+        // it is dropped again before rendering, which reads published snapshots
+        pty_io_lock();
+
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
+            if (frame_pacer_is_wake(&event)) {
+                continue;  // Terminal output; checked below
+            }
+            redraw = true;
             if (event.type == SDL_QUIT) {
                 running = false;
             } else if (event.type == SDL_TEXTINPUT) {
@@ -140,6 +242,22 @@ int main(void) {
             } else if (event.type == SDL_KEYDOWN) {
                 SDL_Keycode sym = event.key.keysym.sym;
 
+                // Work in every mode: F2 profiler overlay, F3 trace, F4 dynamic resolution
+                if (sym == SDLK_F2 || sym == SDLK_F3 || sym == SDLK_F4) {
+                    if (!event.key.repeat) {
+                        if (sym == SDLK_F2) {
+                            profiler_set_overlay(!profiler_overlay_visible());
+                        } else if (sym == SDLK_F3) {
+                            toggle_trace(&game);
+                        } else {
+                            resolution_set_dynamic(&resolution, !resolution.dynamic);
+                            set_hud_message(&game, resolution.dynamic ? "Dynamic resolution on."
+                                                                      : "Dynamic resolution off.");
+                        }
+                    }
+                    continue;
+                }
+
                 // Rename mode input handling
                 if (game.rename_mode) {
                     if (sym == SDLK_RETURN) {
@@ -148,6 +266,7 @@ int main(void) {
                             CabinetEntry *cabinet = &game.cabinets[game.rename_cabinet_index];
                             set_cabinet_custom_name(cabinet, game.rename_buffer);
                             set_cabinet_custom_color(cabinet, get_cabinet_color_by_index(game.rename_color_index));
+                            game.world_version++;
 
                             // Show the new name in confirmation message
                             char msg[128];
@@ -199,6 +318,23 @@ int main(void) {
 
                         SDL_Keymod mod = SDL_GetModState();
                         bool ctrl = (mod & KMOD_CTRL) != 0;
+                        bool shift = (mod & KMOD_SHIFT) != 0;
+
+                        // Shift+PgUp/PgDn page through scrollback instead of reaching the shell
+                        if (shift && (sym == SDLK_PAGEUP || sym == SDLK_PAGEDOWN)) {
+                            terminal_scroll_view(term, sym == SDLK_PAGEUP ? term->rows / 2 : -term->rows / 2);
+                            continue;
+                        }
+
+                        // Ctrl+Shift+V or Shift+Insert pastes the clipboard
+                        if ((ctrl && shift && sym == SDLK_v) || (shift && sym == SDLK_INSERT)) {
+                            char *text = SDL_GetClipboardText();
+                            if (text && *text && terminal_paste(term, text) == TERM_PASTE_TOO_LARGE) {
+                                set_hud_message(&game, "Paste too large for the terminal.");
+                            }
+                            SDL_free(text);
+                            continue;
+                        }
 
                         // Ctrl+key combinations
                         if (ctrl) {
@@ -224,20 +360,21 @@ int main(void) {
                             } else if (sym == SDLK_ESCAPE) {
                                 buf[len++] = '\033';  // ESC now goes to terminal, not exits
                             } else if (sym == SDLK_UP) {
+                                // Application cursor mode (DECCKM) sends ESC O x, as vim and less expect
                                 buf[len++] = '\033';
-                                buf[len++] = '[';
+                                buf[len++] = term->app_cursor_keys ? 'O' : '[';
                                 buf[len++] = 'A';
                             } else if (sym == SDLK_DOWN) {
                                 buf[len++] = '\033';
-                                buf[len++] = '[';
+                                buf[len++] = term->app_cursor_keys ? 'O' : '[';
                                 buf[len++] = 'B';
                             } else if (sym == SDLK_RIGHT) {
                                 buf[len++] = '\033';
-                                buf[len++] = '[';
+                                buf[len++] = term->app_cursor_keys ? 'O' : '[';
                                 buf[len++] = 'C';
                             } else if (sym == SDLK_LEFT) {
                                 buf[len++] = '\033';
-                                buf[len++] = '[';
+                                buf[len++] = term->app_cursor_keys ? 'O' : '[';
                                 buf[len++] = 'D';
                             } else if (sym == SDLK_TAB) {
                                 buf[len++] = '\t';
@@ -249,11 +386,11 @@ int main(void) {
                                 buf[len++] = '~';
                             } else if (sym == SDLK_HOME) {
                                 buf[len++] = '\033';
-                                buf[len++] = '[';
+                                buf[len++] = term->app_cursor_keys ? 'O' : '[';
                                 buf[len++] = 'H';
                             } else if (sym == SDLK_END) {
                                 buf[len++] = '\033';
-                                buf[len++] = '[';
+                                buf[len++] = term->app_cursor_keys ? 'O' : '[';
                                 buf[len++] = 'F';
                             } else if (sym == SDLK_PAGEUP) {
                                 buf[len++] = '\033';
@@ -383,45 +520,54 @@ int main(void) {
         uint64_t currentTicks = SDL_GetTicks64();
         double delta = (currentTicks - lastTicks) / 1000.0;
         lastTicks = currentTicks;
+        // Timers run on wall time; movement takes bounded steps
+        double step = delta < MAX_FRAME_STEP ? delta : MAX_FRAME_STEP;
 
         bool moving_input = false;
+        bool turning = false;
         if (!game.terminal_mode && !game.rename_mode) {
             if (state[SDL_SCANCODE_W]) {
-                move_player(&game, cos(game.player.angle) * MOVE_SPEED * delta,
-                            sin(game.player.angle) * MOVE_SPEED * delta);
+                move_player(&game, cos(game.player.angle) * MOVE_SPEED * step,
+                            sin(game.player.angle) * MOVE_SPEED * step);
                 moving_input = true;
             }
             if (state[SDL_SCANCODE_S]) {
-                move_player(&game, -cos(game.player.angle) * MOVE_SPEED * delta,
-                            -sin(game.player.angle) * MOVE_SPEED * delta);
+                move_player(&game, -cos(game.player.angle) * MOVE_SPEED * step,
+                            -sin(game.player.angle) * MOVE_SPEED * step);
                 moving_input = true;
             }
             if (state[SDL_SCANCODE_Q]) {
-                move_player(&game, cos(game.player.angle - M_PI_2) * STRAFE_SPEED * delta,
-                            sin(game.player.angle - M_PI_2) * STRAFE_SPEED * delta);
+                move_player(&game, cos(game.player.angle - M_PI_2) * STRAFE_SPEED * step,
+                            sin(game.player.angle - M_PI_2) * STRAFE_SPEED * step);
                 moving_input = true;
             }
             if (state[SDL_SCANCODE_E]) {
-                move_player(&game, cos(game.player.angle + M_PI_2) * STRAFE_SPEED * delta,
-                            sin(game.player.angle + M_PI_2) * STRAFE_SPEED * delta);
+                move_player(&game, cos(game.player.angle + M_PI_2) * STRAFE_SPEED * step,
+                            sin(game.player.angle + M_PI_2) * STRAFE_SPEED * step);
                 moving_input = true;
             }
             if (state[SDL_SCANCODE_A] || state[SDL_SCANCODE_LEFT]) {
-                game.player.angle -= ROT_SPEED * delta;
+                game.player.angle -= ROT_SPEED * step;
                 normalize_angle(&game.player.angle);
+                turning = true;
             }
             if (state[SDL_SCANCODE_D] || state[SDL_SCANCODE_RIGHT]) {
-                game.player.angle += ROT_SPEED * delta;
+                game.player.angle += ROT_SPEED * step;
                 normalize_angle(&game.player.angle);
+                turning = true;
             }
         }
-        game_update_hud_bob(&game, moving_input, delta);
+        if (moving_input || turning || !game_hud_bob_settled(&game)) {
+            redraw = true;
+        }
+        game_update_hud_bob(&game, moving_input, step);
 
         if (game.hud_message_timer > 0.0) {
             game.hud_message_timer -= delta;
             if (game.hud_message_timer < 0.0) {
                 game.hud_message_timer = 0.0;
                 game.hud_message[0] = '\0';
+                redraw = true;
             }
         }
 
@@ -448,38 +594,125 @@ int main(void) {
             }
         }
 
-        // Keep terminal sessions alive even when not directly viewed
-        for (int i = 0; i < MAX_TERMINALS; ++i) {
-            terminal_update(&game.terminals[i]);
+        // Send this frame's keystrokes in one write per terminal
+        for (int i = 0; i < MAX_TERMINALS; i++) {
+            terminal_flush_input(&game.terminals[i]);
         }
 
+        // Keep terminal sessions alive even when not directly viewed
+        pty_io_poll(game.terminals, MAX_TERMINALS, 0);
+
         // Decrement skip counter
         if (game.skip_display_frames > 0) {
             game.skip_display_frames--;
+            redraw = true;
         }
 
         game_update_hud_status(&game);
 
+        // Any terminal publishing new content can change what's on screen
+        uint32_t output = 0;
+        for (int i = 0; i < MAX_TERMINALS; i++) {
+            output += game.terminals[i].published.publish_count;
+        }
+        if (output != last_output) {
+            last_output = output;
+            redraw = true;
+        }
+        if (profiler_overlay_visible()) {
+            redraw = true;  // Its numbers change every frame
+        }
+        pty_io_unlock();
+
+        if (!redraw) {
+            // Static scene: sleep until input, terminal output or the HUD
+            // message expiring. Without the I/O thread the PTYs are only read
+            // here, so keep polling them.
+            int timeout = -1;
+            if (game.hud_message_timer > 0.0) {
+                timeout = (int)ceil(game.hud_message_timer * 1000.0);
+            }
+            if (!io_threaded && (timeout < 0 || timeout > IDLE_POLL_MS)) {
+                timeout = IDLE_POLL_MS;
+            }
+            frame_pacer_idle(&pacer, timeout);
+            continue;
+        }
+        redraw = false;
+
+        // The view follows the window size, and the column count under
+        // dynamic resolution
+        int output_width = SCREEN_WIDTH;
+        int output_height = SCREEN_HEIGHT;
+        SDL_GetRendererOutputSize(video.renderer, &output_width, &output_height);
+        int view_width;
+        int view_height;
+        resolution_view_size(&resolution, output_width, output_height, &view_width, &view_height);
+        renderer_set_view_size(view_width, view_height);
+
         // Render terminal or normal scene
-        if (game.terminal_mode && game.active_terminal >= 0 && game.active_terminal < MAX_TERMINALS) {
+        bool terminal_shown = game.terminal_mode && game.active_terminal >= 0 && game.active_terminal < MAX_TERMINALS;
+        int changed = SCENE_HUD_CHANGED;
+        if (terminal_shown) {
             render_terminal(&game.terminals[game.active_terminal], pixels);
         } else {
-            render_scene(&game, pixels, zbuffer);
+            // Unchanged layers are already in their textures
+            changed = render_scene(&game, pixels);
             // Render rename dialog on top if active
             if (game.rename_mode) {
                 render_rename_dialog(pixels, &game);
             }
         }
 
-        SDL_UpdateTexture(video.framebuffer, NULL, pixels, SCREEN_WIDTH * sizeof(uint32_t));
+        uint64_t upload_start = profiler_begin();
+        if (!terminal_shown) {
+            const uint32_t *view = renderer_view(&view_width, &view_height);
+            bool resized = video_sync_view(&video, view_width, view_height);
+            if (video.view && (resized || (changed & SCENE_VIEW_CHANGED))) {
+                SDL_UpdateTexture(video.view, NULL, view, view_width * sizeof(uint32_t));
+            }
+        }
+        if (changed & SCENE_HUD_CHANGED) {
+            SDL_UpdateTexture(video.framebuffer, NULL, pixels, SCREEN_WIDTH * sizeof(uint32_t));
+        }
+        profiler_end(PROF_UPLOAD, upload_start);
+
         SDL_RenderClear(video.renderer);
+        if (terminal_shown) {
+            SDL_SetTextureBlendMode(video.framebuffer, SDL_BLENDMODE_NONE);
+        } else {
+            // The HUD layer is transparent wherever the view shows through
+            SDL_SetTextureBlendMode(video.framebuffer, SDL_BLENDMODE_BLEND);
+            if (video.view) {
+                SDL_RenderCopy(video.renderer, video.view, NULL, NULL);
+            }
+        }
         SDL_RenderCopy(video.renderer, video.framebuffer, NULL, NULL);
+        if (profiler_overlay_visible()) {
+            video_draw_profiler(&video);
+        }
+        if (changed & SCENE_VIEW_CHANGED) {
+            double frame_ms = (SDL_GetPerformanceCounter() - work_start) * 1000.0 / SDL_GetPerformanceFrequency();
+            if (resolution_frame_done(&resolution, frame_ms)) {
+                redraw = true;  // Draw the new size even if nothing else moves
+            }
+        }
+        // Frame time stops before present, which may wait for vsync
+        profiler_end(PROF_FRAME, frame_start);
+        profiler_frame_end();
         SDL_RenderPresent(video.renderer);
+        frame_pacer_end_frame(&pacer);
     }
 
+    if (profiler_tracing()) {
+        profiler_trace_stop(profiler_trace_path());
+    }
+    renderer_shutdown();
     free(pixels);
-    free(zbuffer);
+    pty_io_lock();
     game_cleanup_terminals(&game);
+    pty_io_unlock();
+    pty_io_shutdown();
     game_free_game_maps(&game);
     map_free(&game.map);
     video_destroy(&video);
@@ -3,6 +3,7 @@
 #include "map.h"
 #include "cabinet.h"
 #include "game.h"
+#include "raycast.h"
 #include <math.h>
 #include <stdio.h>
 
@@ -54,31 +55,18 @@ bool ray_pick_wall(const Game *game, double angle, int *wallX, int *wallY, doubl
     const Player *player = &game->player;
     double rayDirX = cos(angle);
     double rayDirY = sin(angle);
-    int mapX = (int)player->x;
-    int mapY = (int)player->y;
+    DdaState dda;
+    dda_begin(&dda, player->x, player->y, rayDirX, rayDirY, dda_delta_dist(rayDirX), dda_delta_dist(rayDirY));
 
-    double deltaDistX = (rayDirX == 0) ? 1e30 : fabs(1.0 / rayDirX);
-    double deltaDistY = (rayDirY == 0) ? 1e30 : fabs(1.0 / rayDirY);
-    int stepX = (rayDirX < 0) ? -1 : 1;
-    int stepY = (rayDirY < 0) ? -1 : 1;
-    double sideDistX = (rayDirX < 0) ? (player->x - mapX) * deltaDistX : (mapX + 1.0 - player->x) * deltaDistX;
-    double sideDistY = (rayDirY < 0) ? (player->y - mapY) * deltaDistY : (mapY + 1.0 - player->y) * deltaDistY;
-    int side = 0;
-
-    while (mapX >= 0 && mapX < game->map.width && mapY >= 0 && mapY < game->map.height) {
-        if (tile_is_wall(game->map.tiles[mapY][mapX])) {
+    while (dda.mapX >= 0 && dda.mapX < game->map.width && dda.mapY >= 0 && dda.mapY < game->map.height) {
+        if (tile_is_wall(game->map.tiles[dda.mapY][dda.mapX])) {
             if (wallX) {
-                *wallX = mapX;
+                *wallX = dda.mapX;
             }
             if (wallY) {
-                *wallY = mapY;
-            }
-            double dist;
-            if (side == 0) {
-                dist = (mapX - player->x + (1 - stepX) / 2.0) / rayDirX;
-            } else {
-                dist = (mapY - player->y + (1 - stepY) / 2.0) / rayDirY;
+                *wallY = dda.mapY;
             }
+            double dist = dda_distance(&dda);
             if (hitX) {
                 *hitX = player->x + dist * rayDirX;
             }
@@ -86,7 +74,7 @@ bool ray_pick_wall(const Game *game, double angle, int *wallX, int *wallY, doubl
                 *hitY = player->y + dist * rayDirY;
             }
             if (normalX && normalY) {
-                if (side == 0) {
+                if (dda.side == 0) {
                     *normalX = (rayDirX > 0) ? -1.0 : 1.0;
                     *normalY = 0.0;
                 } else {
@@ -96,15 +84,7 @@ bool ray_pick_wall(const Game *game, double angle, int *wallX, int *wallY, doubl
             }
             return true;
         }
-        if (sideDistX < sideDistY) {
-            sideDistX += deltaDistX;
-            mapX += stepX;
-            side = 0;
-        } else {
-            sideDistY += deltaDistY;
-            mapY += stepY;
-            side = 1;
-        }
+        dda_step(&dda);
     }
     return false;
 }
@@ -133,6 +113,7 @@ bool toggle_door_state(Game *game, int gx, int gy, bool notify) {
         return false;
     }
     game->door_state[gy][gx] = game->door_state[gy][gx] ? 0 : 1;
+    game->world_version++;
     if (notify) {
         if (game->door_state[gy][gx]) {
             set_hud_message(game, "Door opened.");
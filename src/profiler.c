@@ -0,0 +1,211 @@
+// Frame profiler: scoped pass timers, rolling statistics and Chrome trace capture
+#define _POSIX_C_SOURCE 200809L
+#include "profiler.h"
+#include "types.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    int thread;
+    atomic_int section;  // Section + 1, stored last: 0 means still being written
+} TraceEvent;
+
+static const char *section_names[PROF_SECTION_COUNT] = {
+    "frame", "sky", "floor", "walls", "cabinets", "minimap", "hud", "terminal", "upload",
+};
+
+static atomic_bool overlay_visible = false;
+static atomic_bool tracing = false;
+
+// Time spent in each section since the last profiler_frame_end
+static atomic_uint_fast64_t frame_ns[PROF_SECTION_COUNT];
+
+// Rolling window, only touched by the main thread
+static float window[PROFILER_WINDOW][PROF_SECTION_COUNT];
+static int window_next = 0;
+static int window_count = 0;
+
+static TraceEvent *trace_events = NULL;
+static atomic_int trace_next = 0;
+static uint64_t trace_origin_ns = 0;
+static int trace_main_thread = 0;
+
+static atomic_int thread_count = 0;
+static _Thread_local int thread_id = -1;
+
+static uint64_t profiler_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int profiler_thread(void) {
+    if (thread_id < 0) {
+        thread_id = atomic_fetch_add(&thread_count, 1);
+    }
+    return thread_id;
+}
+
+uint64_t profiler_begin(void) {
+    if (!atomic_load_explicit(&overlay_visible, memory_order_relaxed) &&
+        !atomic_load_explicit(&tracing, memory_order_relaxed)) {
+        return 0;
+    }
+    return profiler_now();
+}
+
+void profiler_end(ProfSection section, uint64_t start) {
+    if (!start) {
+        return;
+    }
+    uint64_t duration = profiler_now() - start;
+    atomic_fetch_add_explicit(&frame_ns[section], duration, memory_order_relaxed);
+
+    if (atomic_load_explicit(&tracing, memory_order_acquire)) {
+        int index = atomic_fetch_add_explicit(&trace_next, 1, memory_order_relaxed);
+        if (index < PROFILER_TRACE_EVENTS) {
+            TraceEvent *event = &trace_events[index];
+            event->start_ns = start;
+            event->duration_ns = duration;
+            event->thread = profiler_thread();
+            atomic_store_explicit(&event->section, (int)section + 1, memory_order_release);
+        }
+    }
+}
+
+void profiler_frame_end(void) {
+    float *row = window[window_next];
+    for (int i = 0; i < PROF_SECTION_COUNT; i++) {
+        row[i] = (float)(atomic_exchange_explicit(&frame_ns[i], 0, memory_order_relaxed) / 1e6);
+    }
+    window_next = (window_next + 1) % PROFILER_WINDOW;
+    if (window_count < PROFILER_WINDOW) {
+        window_count++;
+    }
+}
+
+void profiler_set_overlay(bool visible) {
+    if (visible && !atomic_load(&overlay_visible)) {
+        // Start the window afresh so stale frames don't skew it
+        window_count = 0;
+        window_next = 0;
+        for (int i = 0; i < PROF_SECTION_COUNT; i++) {
+            atomic_store(&frame_ns[i], 0);
+        }
+    }
+    atomic_store(&overlay_visible, visible);
+}
+
+bool profiler_overlay_visible(void) {
+    return atomic_load(&overlay_visible);
+}
+
+static int compare_floats(const void *a, const void *b) {
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+bool profiler_stat(ProfSection section, ProfStat *stat) {
+    if (window_count == 0) {
+        return false;
+    }
+    float samples[PROFILER_WINDOW];
+    double sum = 0.0;
+    for (int i = 0; i < window_count; i++) {
+        samples[i] = window[i][section];
+        sum += samples[i];
+    }
+    qsort(samples, (size_t)window_count, sizeof(float), compare_floats);
+    int p99 = (window_count * 99 + 99) / 100 - 1;
+    stat->avg_ms = sum / window_count;
+    stat->p99_ms = samples[p99];
+    stat->last_ms = window[(window_next + PROFILER_WINDOW - 1) % PROFILER_WINDOW][section];
+    return true;
+}
+
+const char *profiler_section_name(ProfSection section) {
+    return section >= 0 && section < PROF_SECTION_COUNT ? section_names[section] : "?";
+}
+
+bool profiler_trace_start(void) {
+    if (atomic_load(&tracing)) {
+        return true;
+    }
+    if (!trace_events) {
+        trace_events = calloc(PROFILER_TRACE_EVENTS, sizeof(TraceEvent));
+        if (!trace_events) {
+            return false;
+        }
+    } else {
+        memset(trace_events, 0, sizeof(TraceEvent) * PROFILER_TRACE_EVENTS);
+    }
+    atomic_store(&trace_next, 0);
+    trace_origin_ns = profiler_now();
+    trace_main_thread = profiler_thread();
+    atomic_store(&tracing, true);
+    return true;
+}
+
+bool profiler_tracing(void) {
+    return atomic_load(&tracing);
+}
+
+bool profiler_trace_stop(const char *path) {
+    if (!atomic_load(&tracing)) {
+        return false;
+    }
+    atomic_store(&tracing, false);
+
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    int count = atomic_load(&trace_next);
+    if (count > PROFILER_TRACE_EVENTS) {
+        count = PROFILER_TRACE_EVENTS;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    int threads = atomic_load(&thread_count);
+    for (int t = 0; t < threads; t++) {
+        char name[32] = "main";
+        if (t != trace_main_thread) {
+            snprintf(name, sizeof(name), "thread %d", t);
+        }
+        fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n",
+                t, name);
+    }
+    for (int i = 0; i < count; i++) {
+        const TraceEvent *event = &trace_events[i];
+        int section = atomic_load_explicit(&event->section, memory_order_acquire) - 1;
+        if (section < 0 || event->start_ns < trace_origin_ns) {
+            continue;  // Still being written when capture stopped, or began before it
+        }
+        fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},\n",
+                section_names[section], event->thread, (event->start_ns - trace_origin_ns) / 1e3,
+                event->duration_ns / 1e3);
+    }
+    // Trailing entry so every real event can end with a comma
+    fprintf(file, "{\"name\":\"trace_end\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}\n]}\n",
+            trace_main_thread, (profiler_now() - trace_origin_ns) / 1e3);
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+#if DEBUG_MODE
+    printf("[DEBUG] Wrote %d trace events to %s\n", count, path);
+#endif
+    return ok;
+}
+
+const char *profiler_trace_path(void) {
+    const char *env = getenv("TSS_TRACE_FILE");
+    return env && *env ? env : "tss-trace.json";
+}
@@ -0,0 +1,59 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Timed passes. Sky, floor and walls run on the render workers, so their
+// numbers are thread time summed over tiles, not wall time.
+typedef enum {
+    PROF_FRAME = 0,  // Whole frame on the main thread, excluding pacing sleeps
+    PROF_SKY,
+    PROF_FLOOR,
+    PROF_WALLS,
+    PROF_CABINETS,
+    PROF_MINIMAP,
+    PROF_HUD,
+    PROF_TERMINAL,   // terminal_drain, from terminal_update or the PTY I/O thread
+    PROF_UPLOAD,     // SDL_UpdateTexture of the framebuffer
+    PROF_SECTION_COUNT
+} ProfSection;
+
+// Frames kept for the rolling averages and p99
+#define PROFILER_WINDOW 240
+
+// Events kept by one trace capture; later ones are dropped
+#define PROFILER_TRACE_EVENTS (1 << 18)
+
+typedef struct {
+    double avg_ms;
+    double p99_ms;
+    double last_ms;
+} ProfStat;
+
+// Timers are no-ops (one atomic load) unless the overlay is shown or a
+// trace is being captured
+uint64_t profiler_begin(void);
+void profiler_end(ProfSection section, uint64_t start);
+
+// Close the current frame: per-section totals move into the rolling window
+void profiler_frame_end(void);
+
+void profiler_set_overlay(bool visible);
+bool profiler_overlay_visible(void);
+
+// Statistics over the last frames for the overlay; false until a frame is in
+bool profiler_stat(ProfSection section, ProfStat *stat);
+const char *profiler_section_name(ProfSection section);
+
+// Start recording every timed scope, or stop and write what was recorded as
+// a Chrome trace (chrome://tracing, Perfetto). Returns false if the buffer
+// can't be allocated or the file can't be written.
+bool profiler_trace_start(void);
+bool profiler_trace_stop(const char *path);
+bool profiler_tracing(void);
+
+// Trace file from TSS_TRACE_FILE, "tss-trace.json" if unset
+const char *profiler_trace_path(void);
+
+#endif // PROFILER_H
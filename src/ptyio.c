@@ -0,0 +1,328 @@
+// Event-driven PTY servicing: epoll over the PTY masters plus a signalfd for SIGCHLD,
+// run from a dedicated I/O thread that owns reading and ANSI parsing
+#define _POSIX_C_SOURCE 200809L
+#include "ptyio.h"
+#include "terminal.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#define PTY_IO_REACTOR 1
+#else
+#define PTY_IO_REACTOR 0
+#endif
+
+// Bytes parsed per terminal before the I/O thread drops the lock again
+#define PTY_IO_THREAD_CHUNK (64 * 1024)
+
+static bool pty_io_ready = false;
+
+// io_mutex guards parser and lifecycle state, snapshot_mutex the published copies
+static pthread_mutex_t io_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t snapshot_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#if PTY_IO_REACTOR
+static int epoll_fd = -1;
+static int signal_fd = -1;
+static int wake_fd = -1;
+
+static pthread_t io_thread;
+static bool io_thread_running = false;
+static bool io_thread_stopping = false;
+static Terminal *io_terms = NULL;
+static int io_term_count = 0;
+static void (*io_notify)(void) = NULL;
+
+static void child_signal_set(sigset_t *set) {
+    sigemptyset(set);
+    sigaddset(set, SIGCHLD);
+}
+
+// Reap every exited child and close the terminal it belonged to
+static void reap_children(Terminal *terms, int count) {
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        for (int i = 0; i < count; i++) {
+            if (terms[i].active && terms[i].shell_pid == pid) {
+                terms[i].shell_pid = -1;  // Already gone, nothing to signal
+                terminal_close(&terms[i]);
+#if DEBUG_MODE
+                printf("[DEBUG] Shell %d for terminal %d exited\n", (int)pid, i);
+#endif
+                break;
+            }
+        }
+    }
+}
+#endif
+
+bool pty_io_init(void) {
+#if PTY_IO_REACTOR
+    if (pty_io_ready) {
+        return true;
+    }
+
+    sigset_t mask;
+    child_signal_set(&mask);
+    if (pthread_sigmask(SIG_BLOCK, &mask, NULL) != 0) {
+        return false;
+    }
+
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+    struct epoll_event wake_ev = {.events = EPOLLIN, .data.ptr = &wake_fd};
+    if (epoll_fd < 0 || signal_fd < 0 || wake_fd < 0 ||
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signal_fd, &ev) != 0 ||
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &wake_ev) != 0) {
+        perror("pty_io_init");
+        pty_io_shutdown();
+        return false;
+    }
+
+    pty_io_ready = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void pty_io_shutdown(void) {
+#if PTY_IO_REACTOR
+    if (io_thread_running) {
+        pthread_mutex_lock(&io_mutex);
+        io_thread_stopping = true;
+        pthread_mutex_unlock(&io_mutex);
+        uint64_t one = 1;
+        if (write(wake_fd, &one, sizeof(one)) < 0) {
+            perror("pty_io_shutdown");
+        }
+        pthread_join(io_thread, NULL);
+        io_thread_running = false;
+    }
+    if (wake_fd >= 0) {
+        close(wake_fd);
+        wake_fd = -1;
+    }
+    if (signal_fd >= 0) {
+        close(signal_fd);
+        signal_fd = -1;
+    }
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+        epoll_fd = -1;
+    }
+    sigset_t mask;
+    child_signal_set(&mask);
+    pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+    pty_io_ready = false;
+#endif
+}
+
+void pty_io_child_reset(void) {
+#if PTY_IO_REACTOR
+    sigset_t mask;
+    child_signal_set(&mask);
+    sigprocmask(SIG_UNBLOCK, &mask, NULL);
+#endif
+}
+
+void pty_io_watch(Terminal *term) {
+#if PTY_IO_REACTOR
+    if (!pty_io_ready || term->pty_fd < 0) {
+        return;
+    }
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = term};
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, term->pty_fd, &ev) != 0) {
+        perror("epoll_ctl");
+    }
+#else
+    (void)term;
+#endif
+}
+
+void pty_io_unwatch(Terminal *term) {
+#if PTY_IO_REACTOR
+    if (!pty_io_ready || term->pty_fd < 0) {
+        return;
+    }
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, term->pty_fd, NULL);
+#else
+    (void)term;
+#endif
+}
+
+void pty_io_watch_output(Terminal *term, bool enable) {
+#if PTY_IO_REACTOR
+    if (!pty_io_ready || term->pty_fd < 0) {
+        return;
+    }
+    struct epoll_event ev = {.events = EPOLLIN | (enable ? EPOLLOUT : 0), .data.ptr = term};
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, term->pty_fd, &ev) != 0) {
+        perror("epoll_ctl");
+    }
+#else
+    (void)term;
+    (void)enable;
+#endif
+}
+
+void pty_io_lock(void) {
+    pthread_mutex_lock(&io_mutex);
+}
+
+void pty_io_unlock(void) {
+    pthread_mutex_unlock(&io_mutex);
+}
+
+void pty_io_snapshot_lock(void) {
+    pthread_mutex_lock(&snapshot_mutex);
+}
+
+void pty_io_snapshot_unlock(void) {
+    pthread_mutex_unlock(&snapshot_mutex);
+}
+
+#if PTY_IO_REACTOR
+// Handle one epoll batch. Called with io_mutex held. Returns whether any
+// terminal may look different afterwards.
+static bool dispatch_events(const struct epoll_event *events, int ready,
+                            Terminal *terms, int count, size_t limit) {
+    bool reap = false;
+    bool changed = false;
+    for (int i = 0; i < ready; i++) {
+        void *tag = events[i].data.ptr;
+        if (tag == &wake_fd) {
+            uint64_t value;
+            while (read(wake_fd, &value, sizeof(value)) == (ssize_t)sizeof(value)) {
+            }
+            continue;
+        }
+        if (!tag) {
+            // Consume the queued SIGCHLDs; the reap below handles all of them
+            struct signalfd_siginfo info;
+            while (read(signal_fd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+            }
+            reap = true;
+            continue;
+        }
+        Terminal *term = tag;
+        if (!term->active) {
+            continue;
+        }
+        if (events[i].events & EPOLLOUT) {
+            // The shell caught up with a blocked flush
+            terminal_flush_input(term);
+        }
+        if ((events[i].events & ~(uint32_t)EPOLLOUT) && term->active) {
+            changed = true;
+            if (!terminal_drain(term, limit)) {
+                // Hangup or read error; the shell's SIGCHLD reaps it
+                terminal_close(term);
+                reap = true;
+            }
+        }
+    }
+
+    if (reap) {
+        reap_children(terms, count);
+    }
+    return changed || reap;
+}
+
+static void *pty_io_thread_main(void *arg) {
+    (void)arg;
+    struct epoll_event events[MAX_TERMINALS + 2];
+    for (;;) {
+        int ready = epoll_wait(epoll_fd, events, MAX_TERMINALS + 2, -1);
+        if (ready < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+
+        pthread_mutex_lock(&io_mutex);
+        bool stop = io_thread_stopping;
+        bool changed = false;
+        if (!stop && ready > 0) {
+            changed = dispatch_events(events, ready, io_terms, io_term_count, PTY_IO_THREAD_CHUNK);
+        }
+        pthread_mutex_unlock(&io_mutex);
+        if (stop) {
+            break;
+        }
+        if (changed && io_notify) {
+            io_notify();
+        }
+    }
+    return NULL;
+}
+#endif
+
+void pty_io_set_notify(void (*notify)(void)) {
+#if PTY_IO_REACTOR
+    io_notify = notify;
+#else
+    (void)notify;
+#endif
+}
+
+bool pty_io_start(Terminal *terms, int count) {
+#if PTY_IO_REACTOR
+    if (!pty_io_ready || io_thread_running) {
+        return io_thread_running;
+    }
+    io_terms = terms;
+    io_term_count = count;
+    io_thread_stopping = false;
+    if (pthread_create(&io_thread, NULL, pty_io_thread_main, NULL) != 0) {
+        perror("pthread_create");
+        return false;
+    }
+    io_thread_running = true;
+#if DEBUG_MODE
+    printf("[DEBUG] PTY I/O thread started for %d terminals\n", count);
+#endif
+    return true;
+#else
+    (void)terms;
+    (void)count;
+    return false;
+#endif
+}
+
+void pty_io_poll(Terminal *terms, int count, int timeout_ms) {
+    if (!pty_io_ready) {
+        // No reactor: poll every slot
+        for (int i = 0; i < count; ++i) {
+            terminal_update(&terms[i]);
+        }
+        return;
+    }
+
+#if PTY_IO_REACTOR
+    if (io_thread_running) {
+        return;  // The I/O thread owns the PTYs
+    }
+
+    struct epoll_event events[MAX_TERMINALS + 2];
+    int ready = epoll_wait(epoll_fd, events, MAX_TERMINALS + 2, timeout_ms);
+    if (ready < 0) {
+        if (errno != EINTR) {
+            perror("epoll_wait");
+        }
+        return;
+    }
+    dispatch_events(events, ready, terms, count, TERM_DRAIN_LIMIT);
+#else
+    (void)timeout_ms;
+#endif
+}
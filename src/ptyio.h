@@ -0,0 +1,43 @@
+#ifndef PTYIO_H
+#define PTYIO_H
+
+#include "types.h"
+
+// Set up the PTY reactor (epoll + signalfd for SIGCHLD on Linux). Must run
+// before any other thread is created so they all inherit the blocked SIGCHLD.
+// Returns false when unavailable; pty_io_poll then falls back to polling.
+bool pty_io_init(void);
+void pty_io_shutdown(void);
+
+// Called from the forked child before exec to restore the signal mask
+void pty_io_child_reset(void);
+
+// Register or unregister a terminal's PTY master with the reactor
+void pty_io_watch(Terminal *term);
+void pty_io_unwatch(Terminal *term);
+
+// Also wake for the PTY becoming writable, to finish a blocked input flush
+void pty_io_watch_output(Terminal *term, bool enable);
+
+// Hand PTY reading and parsing for terms[0..count) to a background thread.
+// Returns false (and leaves pty_io_poll in charge) if it can't be started.
+bool pty_io_start(Terminal *terms, int count);
+
+// Called by the I/O thread, without the lock held, after it parsed output or
+// reaped a shell. Set before pty_io_start.
+void pty_io_set_notify(void (*notify)(void));
+
+// Service readable PTYs and reap exited shells, waiting up to timeout_ms
+// (0 = don't block) for activity. A no-op while the I/O thread is running.
+void pty_io_poll(Terminal *terms, int count, int timeout_ms);
+
+// Held by the game thread around anything that spawns, closes, writes to or
+// re-initializes terminals; the I/O thread holds it while parsing
+void pty_io_lock(void);
+void pty_io_unlock(void);
+
+// Guards Terminal.published; held by the renderer while it reads snapshots
+void pty_io_snapshot_lock(void);
+void pty_io_snapshot_unlock(void);
+
+#endif // PTYIO_H
@@ -0,0 +1,76 @@
+// DDA grid traversal backends (double and 16.16 fixed-point)
+#include "raycast.h"
+#include <math.h>
+
+double dda_delta_dist(double rayDir) {
+    return (rayDir == 0) ? 1e30 : fabs(1.0 / rayDir);
+}
+
+void dda_double_begin(DdaDouble *dda, double posX, double posY, double rayDirX, double rayDirY,
+                      double deltaDistX, double deltaDistY) {
+    dda->posX = posX;
+    dda->posY = posY;
+    dda->rayDirX = rayDirX;
+    dda->rayDirY = rayDirY;
+    dda->mapX = (int)posX;
+    dda->mapY = (int)posY;
+    dda->deltaDistX = deltaDistX;
+    dda->deltaDistY = deltaDistY;
+    dda->stepX = (rayDirX < 0) ? -1 : 1;
+    dda->stepY = (rayDirY < 0) ? -1 : 1;
+    dda->side = 0;
+
+    if (rayDirX < 0) {
+        dda->sideDistX = (posX - dda->mapX) * deltaDistX;
+    } else {
+        dda->sideDistX = (dda->mapX + 1.0 - posX) * deltaDistX;
+    }
+    if (rayDirY < 0) {
+        dda->sideDistY = (posY - dda->mapY) * deltaDistY;
+    } else {
+        dda->sideDistY = (dda->mapY + 1.0 - posY) * deltaDistY;
+    }
+}
+
+// Fractional position of the hit along the crossed wall face, in [0, 1)
+double dda_double_wall_x(const DdaDouble *dda) {
+    double dist = dda_double_distance(dda);
+    double wallX = (dda->side == 0) ? dda->posY + dist * dda->rayDirY : dda->posX + dist * dda->rayDirX;
+    return wallX - floor(wallX);
+}
+
+static int32_t to_fixed_delta(double deltaDist) {
+    if (deltaDist * DDA_FIX_ONE >= DDA_FIX_MAX_DELTA) {
+        return DDA_FIX_MAX_DELTA;
+    }
+    return (int32_t)(deltaDist * DDA_FIX_ONE);
+}
+
+void dda_fixed_begin(DdaFixed *dda, double posX, double posY, double rayDirX, double rayDirY,
+                     double deltaDistX, double deltaDistY) {
+    dda->posX = (int32_t)(posX * DDA_FIX_ONE);
+    dda->posY = (int32_t)(posY * DDA_FIX_ONE);
+    dda->rayDirX = (int32_t)(rayDirX * DDA_FIX_ONE);
+    dda->rayDirY = (int32_t)(rayDirY * DDA_FIX_ONE);
+    dda->mapX = dda->posX >> DDA_FIX_SHIFT;
+    dda->mapY = dda->posY >> DDA_FIX_SHIFT;
+    dda->deltaDistX = to_fixed_delta(deltaDistX);
+    dda->deltaDistY = to_fixed_delta(deltaDistY);
+    dda->stepX = (rayDirX < 0) ? -1 : 1;
+    dda->stepY = (rayDirY < 0) ? -1 : 1;
+    dda->side = 0;
+
+    int32_t cellX = dda->mapX << DDA_FIX_SHIFT;
+    int32_t cellY = dda->mapY << DDA_FIX_SHIFT;
+    int32_t fracX = (rayDirX < 0) ? dda->posX - cellX : cellX + DDA_FIX_ONE - dda->posX;
+    int32_t fracY = (rayDirY < 0) ? dda->posY - cellY : cellY + DDA_FIX_ONE - dda->posY;
+    dda->sideDistX = (int32_t)(((int64_t)fracX * dda->deltaDistX) >> DDA_FIX_SHIFT);
+    dda->sideDistY = (int32_t)(((int64_t)fracY * dda->deltaDistY) >> DDA_FIX_SHIFT);
+}
+
+double dda_fixed_wall_x(const DdaFixed *dda) {
+    int64_t dist = dda_fixed_distance_fix(dda);
+    int64_t wallX = (dda->side == 0) ? dda->posY + ((dist * dda->rayDirY) >> DDA_FIX_SHIFT)
+                                     : dda->posX + ((dist * dda->rayDirX) >> DDA_FIX_SHIFT);
+    return (wallX & (DDA_FIX_ONE - 1)) / (double)DDA_FIX_ONE;
+}
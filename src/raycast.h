@@ -0,0 +1,111 @@
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+#include <stdint.h>
+
+// DDA grid traversal shared by the wall renderer, door overlay and ray picking.
+// Build with -DTSS_FIXED_DDA=1 (make FIXED_DDA=1) to use the 16.16 fixed-point
+// backend instead of doubles; both backends stay available for benchmarking.
+#ifndef TSS_FIXED_DDA
+#define TSS_FIXED_DDA 0
+#endif
+
+#define DDA_FIX_SHIFT 16
+#define DDA_FIX_ONE (1 << DDA_FIX_SHIFT)
+#define DDA_FIX_MAX_DELTA (1 << 28)  // Clamp for near axis-parallel rays, keeps side distances in int32
+
+typedef struct {
+    int mapX;
+    int mapY;
+    int stepX;
+    int stepY;
+    int side;  // 0 = last step crossed an X grid line, 1 = a Y grid line
+    double posX;
+    double posY;
+    double rayDirX;
+    double rayDirY;
+    double sideDistX;
+    double sideDistY;
+    double deltaDistX;
+    double deltaDistY;
+} DdaDouble;
+
+typedef struct {
+    int mapX;
+    int mapY;
+    int stepX;
+    int stepY;
+    int side;
+    int32_t posX;  // All distances and coordinates in 16.16
+    int32_t posY;
+    int32_t rayDirX;
+    int32_t rayDirY;
+    int32_t sideDistX;
+    int32_t sideDistY;
+    int32_t deltaDistX;
+    int32_t deltaDistY;
+} DdaFixed;
+
+// |1 / rayDir|, or 1e30 for a ray parallel to the axis
+double dda_delta_dist(double rayDir);
+
+void dda_double_begin(DdaDouble *dda, double posX, double posY, double rayDirX, double rayDirY,
+                      double deltaDistX, double deltaDistY);
+double dda_double_wall_x(const DdaDouble *dda);
+
+static inline void dda_double_step(DdaDouble *dda) {
+    if (dda->sideDistX < dda->sideDistY) {
+        dda->sideDistX += dda->deltaDistX;
+        dda->mapX += dda->stepX;
+        dda->side = 0;
+    } else {
+        dda->sideDistY += dda->deltaDistY;
+        dda->mapY += dda->stepY;
+        dda->side = 1;
+    }
+}
+
+// Perpendicular distance to the grid line crossed by the last step
+static inline double dda_double_distance(const DdaDouble *dda) {
+    return (dda->side == 0) ? (dda->sideDistX - dda->deltaDistX) : (dda->sideDistY - dda->deltaDistY);
+}
+
+void dda_fixed_begin(DdaFixed *dda, double posX, double posY, double rayDirX, double rayDirY,
+                     double deltaDistX, double deltaDistY);
+double dda_fixed_wall_x(const DdaFixed *dda);
+
+static inline void dda_fixed_step(DdaFixed *dda) {
+    if (dda->sideDistX < dda->sideDistY) {
+        dda->sideDistX += dda->deltaDistX;
+        dda->mapX += dda->stepX;
+        dda->side = 0;
+    } else {
+        dda->sideDistY += dda->deltaDistY;
+        dda->mapY += dda->stepY;
+        dda->side = 1;
+    }
+}
+
+static inline int32_t dda_fixed_distance_fix(const DdaFixed *dda) {
+    return (dda->side == 0) ? (dda->sideDistX - dda->deltaDistX) : (dda->sideDistY - dda->deltaDistY);
+}
+
+static inline double dda_fixed_distance(const DdaFixed *dda) {
+    return dda_fixed_distance_fix(dda) / (double)DDA_FIX_ONE;
+}
+
+#if TSS_FIXED_DDA
+typedef DdaFixed DdaState;
+#define dda_begin dda_fixed_begin
+#define dda_step dda_fixed_step
+#define dda_distance dda_fixed_distance
+#define dda_wall_x dda_fixed_wall_x
+#else
+typedef DdaDouble DdaState;
+#define dda_begin dda_double_begin
+#define dda_step dda_double_step
+#define dda_distance dda_double_distance
+#define dda_wall_x dda_double_wall_x
+#endif
+
+#endif // RAYCAST_H
@@ -6,198 +6,375 @@
 #include "ui.h"
 #include "display.h"
 #include "cabinet.h"
-#include "../include/font8x8_basic.h"
+#include "jobs.h"
+#include "raycast.h"
+#include "floorcast.h"
+#include "ptyio.h"
+#include "terminal.h"
+#include "glyphs.h"
+#include "profiler.h"
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <SDL2/SDL.h>
 
-// ANSI color palette (16 colors)
-static const uint32_t ansi_colors[16] = {
-    0xFF000000, // 0: Black
-    0xFFAA0000, // 1: Red
-    0xFF00AA00, // 2: Green
-    0xFFAA5500, // 3: Yellow/Brown
-    0xFF0000AA, // 4: Blue
-    0xFFAA00AA, // 5: Magenta
-    0xFF00AAAA, // 6: Cyan
-    0xFFAAAAAA, // 7: White/Gray
-    0xFF555555, // 8: Bright Black/Gray
-    0xFFFF5555, // 9: Bright Red
-    0xFF55FF55, // 10: Bright Green
-    0xFFFFFF55, // 11: Bright Yellow
-    0xFF5555FF, // 12: Bright Blue
-    0xFFFF55FF, // 13: Bright Magenta
-    0xFF55FFFF, // 14: Bright Cyan
-    0xFFFFFFFF  // 15: Bright White
-};
-
-int render_cabinets(const Game *game, uint32_t *pixels, double dirX, double dirY, double planeX, double planeY,
-                    double *zbuffer) {
-    const Player *player = &game->player;
-    int highlight = -1;
-    double highlightDepth = 1e9;
-    int crossX = SCREEN_WIDTH / 2;
-    int crossY = SCREEN_HEIGHT / 2;
-    int count = game->cabinet_count < MAX_CABINETS ? game->cabinet_count : MAX_CABINETS;
-
-    // Cabinet dimensions (oriented box aligned to grid)
-    double boxWidth = 0.8;   // X/Y size
-    double boxDepth = 0.5;   // Depth
-    double boxHeight = 1.2;  // Tall server cabinet
-
-    for (int i = 0; i < count; ++i) {
-        const CabinetEntry *entry = &game->cabinets[i];
-
-        // Render cabinet as a 3D box - scan each vertical stripe
-        // Cabinet is axis-aligned in grid space
-        double minX = entry->x - boxWidth / 2.0;
-        double maxX = entry->x + boxWidth / 2.0;
-        double minY = entry->y - boxDepth / 2.0;
-        double maxY = entry->y + boxDepth / 2.0;
-
-        // For each screen column, raycast to find if we hit the box
-        for (int x = 0; x < SCREEN_WIDTH; ++x) {
-            double cameraX = 2.0 * x / (double)SCREEN_WIDTH - 1.0;
-            double rayDirX = dirX + planeX * cameraX;
-            double rayDirY = dirY + planeY * cameraX;
-
-            // Check intersection with the 4 vertical faces of the box
-            double hitDist = 1e9;
-            int hitFace = -1;  // 0=front, 1=right, 2=back, 3=left
-            double hitTexU = 0;
-
-            // Face 0: Front face (Y = minY)
-            if (fabs(rayDirY) > 0.001) {
-                double t = (minY - player->y) / rayDirY;
-                if (t > 0.1) {
-                    double hitX = player->x + t * rayDirX;
-                    if (hitX >= minX && hitX <= maxX) {
-                        if (t < hitDist) {
-                            hitDist = t;
-                            hitFace = 0;
-                            hitTexU = (hitX - minX) / boxWidth;
-                        }
-                    }
-                }
+// Cabinet dimensions (oriented box aligned to grid)
+#define CABINET_BOX_WIDTH 0.8    // X/Y size
+#define CABINET_BOX_DEPTH 0.5    // Depth
+#define CABINET_BOX_HEIGHT 1.2   // Tall server cabinet
+#define CABINET_NEAR_PLANE 0.1
+
+typedef struct {
+    int index;
+    double minX;
+    double maxX;
+    double minY;
+    double maxY;
+    double nearDepth;  // Closest corner depth along the view direction
+    int x0;            // Screen columns the box can cover (inclusive)
+    int x1;
+} CabinetSpan;
+
+// Intersect a column ray with the 4 vertical faces of a cabinet box.
+// Returns the face hit (0=front, 1=right, 2=back, 3=left) or -1.
+static int intersect_cabinet_box(const Player *player, const CabinetSpan *span, double rayDirX, double rayDirY,
+                                 double *outDist, double *outTexU) {
+    double hitDist = 1e9;
+    int hitFace = -1;
+    double hitTexU = 0;
+
+    // Face 0: Front face (Y = minY)
+    if (fabs(rayDirY) > 0.001) {
+        double t = (span->minY - player->y) / rayDirY;
+        if (t > CABINET_NEAR_PLANE) {
+            double hitX = player->x + t * rayDirX;
+            if (hitX >= span->minX && hitX <= span->maxX && t < hitDist) {
+                hitDist = t;
+                hitFace = 0;
+                hitTexU = (hitX - span->minX) / CABINET_BOX_WIDTH;
             }
+        }
+    }
 
-            // Face 1: Right face (X = maxX)
-            if (fabs(rayDirX) > 0.001) {
-                double t = (maxX - player->x) / rayDirX;
-                if (t > 0.1) {
-                    double hitY = player->y + t * rayDirY;
-                    if (hitY >= minY && hitY <= maxY) {
-                        if (t < hitDist) {
-                            hitDist = t;
-                            hitFace = 1;
-                            hitTexU = (hitY - minY) / boxDepth;
-                        }
-                    }
-                }
+    // Face 1: Right face (X = maxX)
+    if (fabs(rayDirX) > 0.001) {
+        double t = (span->maxX - player->x) / rayDirX;
+        if (t > CABINET_NEAR_PLANE) {
+            double hitY = player->y + t * rayDirY;
+            if (hitY >= span->minY && hitY <= span->maxY && t < hitDist) {
+                hitDist = t;
+                hitFace = 1;
+                hitTexU = (hitY - span->minY) / CABINET_BOX_DEPTH;
             }
+        }
+    }
 
-            // Face 2: Back face (Y = maxY)
-            if (fabs(rayDirY) > 0.001) {
-                double t = (maxY - player->y) / rayDirY;
-                if (t > 0.1) {
-                    double hitX = player->x + t * rayDirX;
-                    if (hitX >= minX && hitX <= maxX) {
-                        if (t < hitDist) {
-                            hitDist = t;
-                            hitFace = 2;
-                            hitTexU = (maxX - hitX) / boxWidth;
-                        }
-                    }
-                }
+    // Face 2: Back face (Y = maxY)
+    if (fabs(rayDirY) > 0.001) {
+        double t = (span->maxY - player->y) / rayDirY;
+        if (t > CABINET_NEAR_PLANE) {
+            double hitX = player->x + t * rayDirX;
+            if (hitX >= span->minX && hitX <= span->maxX && t < hitDist) {
+                hitDist = t;
+                hitFace = 2;
+                hitTexU = (span->maxX - hitX) / CABINET_BOX_WIDTH;
             }
+        }
+    }
 
-            // Face 3: Left face (X = minX)
-            if (fabs(rayDirX) > 0.001) {
-                double t = (minX - player->x) / rayDirX;
-                if (t > 0.1) {
-                    double hitY = player->y + t * rayDirY;
-                    if (hitY >= minY && hitY <= maxY) {
-                        if (t < hitDist) {
-                            hitDist = t;
-                            hitFace = 3;
-                            hitTexU = (maxY - hitY) / boxDepth;
-                        }
-                    }
-                }
+    // Face 3: Left face (X = minX)
+    if (fabs(rayDirX) > 0.001) {
+        double t = (span->minX - player->x) / rayDirX;
+        if (t > CABINET_NEAR_PLANE) {
+            double hitY = player->y + t * rayDirY;
+            if (hitY >= span->minY && hitY <= span->maxY && t < hitDist) {
+                hitDist = t;
+                hitFace = 3;
+                hitTexU = (span->maxY - hitY) / CABINET_BOX_DEPTH;
             }
+        }
+    }
 
-            // If we hit a face, render it
-            if (hitFace >= 0 && hitDist < zbuffer[x]) {
-                zbuffer[x] = hitDist;
+    *outDist = hitDist;
+    *outTexU = hitTexU;
+    return hitFace;
+}
 
-                // Calculate wall height on screen
-                int wallHeight = (int)(SCREEN_HEIGHT / hitDist * boxHeight);
-                if (wallHeight < 1) wallHeight = 1;
+// Project a cabinet's footprint to the screen columns it can cover.
+// Returns false when the box is entirely behind the camera or off-screen.
+static bool project_cabinet(const Player *player, const RayTable *rays, const CabinetEntry *entry,
+                            CabinetSpan *span) {
+    span->minX = entry->x - CABINET_BOX_WIDTH / 2.0;
+    span->maxX = entry->x + CABINET_BOX_WIDTH / 2.0;
+    span->minY = entry->y - CABINET_BOX_DEPTH / 2.0;
+    span->maxY = entry->y + CABINET_BOX_DEPTH / 2.0;
+
+    double invDet = 1.0 / (rays->planeX * rays->dirY - rays->dirX * rays->planeY);
+    double cornersX[4] = {span->minX, span->maxX, span->maxX, span->minX};
+    double cornersY[4] = {span->minY, span->minY, span->maxY, span->maxY};
+    double minScreenX = 1e9;
+    double maxScreenX = -1e9;
+    bool straddlesNearPlane = false;
+    span->nearDepth = 1e9;
+
+    for (int c = 0; c < 4; ++c) {
+        double dx = cornersX[c] - player->x;
+        double dy = cornersY[c] - player->y;
+        // Camera space: depth along the view direction, lateral offset along the plane
+        double depth = invDet * (-rays->planeY * dx + rays->planeX * dy);
+        double lateral = invDet * (rays->dirY * dx - rays->dirX * dy);
+        if (depth < span->nearDepth) {
+            span->nearDepth = depth;
+        }
+        if (depth <= CABINET_NEAR_PLANE) {
+            straddlesNearPlane = true;
+            continue;
+        }
+        double screenX = (rays->width / 2.0) * (1.0 + lateral / depth);
+        if (screenX < minScreenX) minScreenX = screenX;
+        if (screenX > maxScreenX) maxScreenX = screenX;
+    }
 
-                int drawStartY = -wallHeight / 2 + SCREEN_HEIGHT / 2;
-                int drawEndY = wallHeight / 2 + SCREEN_HEIGHT / 2;
-                if (drawStartY < 0) drawStartY = 0;
-                if (drawEndY >= SCREEN_HEIGHT) drawEndY = SCREEN_HEIGHT - 1;
+    if (minScreenX > maxScreenX) {
+        return false;  // Every corner is behind the near plane
+    }
+    if (straddlesNearPlane) {
+        // Partially behind the camera: projection is unbounded, test every column
+        span->x0 = 0;
+        span->x1 = rays->width - 1;
+        return true;
+    }
+    if (maxScreenX < -1.0 || minScreenX > rays->width + 1.0) {
+        return false;
+    }
+    span->x0 = clamp_int((int)floor(minScreenX) - 1, 0, rays->width - 1);
+    span->x1 = clamp_int((int)ceil(maxScreenX) + 1, 0, rays->width - 1);
+    return true;
+}
 
-                // Check for crosshair hit
-                if (x == crossX && crossY >= drawStartY && crossY <= drawEndY) {
-                    if (hitDist < highlightDepth) {
-                        highlightDepth = hitDist;
-                        highlight = i;
-                    }
-                }
+int render_cabinets(const Game *game, uint32_t *pixels, const RayTable *rays, double *zbuffer) {
+    const Player *player = &game->player;
+    int crossX = rays->width / 2;
+    int height = rays->height;
+    int count = game->cabinet_count < MAX_CABINETS ? game->cabinet_count : MAX_CABINETS;
 
-                // Texture coordinates
-                int texX = (int)(hitTexU * TEX_SIZE) & (TEX_SIZE - 1);
+    // Project and cull against the frustum and the wall zbuffer
+    CabinetSpan spans[MAX_CABINETS];
+    int visible = 0;
+    for (int i = 0; i < count; ++i) {
+        CabinetSpan *span = &spans[visible];
+        span->index = i;
+        if (!project_cabinet(player, rays, &game->cabinets[i], span)) {
+            continue;
+        }
+        bool occluded = true;
+        for (int x = span->x0; x <= span->x1; ++x) {
+            if (span->nearDepth < zbuffer[x]) {
+                occluded = false;
+                break;
+            }
+        }
+        if (!occluded) {
+            visible++;
+        }
+    }
 
-                // Render vertical stripe
-                for (int y = drawStartY; y <= drawEndY; ++y) {
-                    double texYf = (double)(y - drawStartY) / (double)wallHeight;
-                    int texY = (int)(texYf * TEX_SIZE) & (TEX_SIZE - 1);
+    // Nearest first, so farther cabinets fail the zbuffer test instead of being overdrawn
+    for (int i = 1; i < visible; ++i) {
+        CabinetSpan key = spans[i];
+        int j = i - 1;
+        while (j >= 0 && spans[j].nearDepth > key.nearDepth) {
+            spans[j + 1] = spans[j];
+            j--;
+        }
+        spans[j + 1] = key;
+    }
 
-                    // Use cabinet's texture variation
-                    int texIdx = entry->texture_index % NUM_CABINET_TEXTURES;
-                    uint32_t color = cabinet_textures[texIdx][texY * TEX_SIZE + texX];
+    // The crosshair target is the nearest cabinet hit in the centre column in front of the walls
+    int highlight = -1;
+    double highlightDepth = zbuffer[crossX];
+    for (int s = 0; s < visible; ++s) {
+        const CabinetSpan *span = &spans[s];
+        if (crossX < span->x0 || crossX > span->x1) {
+            continue;
+        }
+        double hitDist;
+        double hitTexU;
+        const ColumnRay *ray = &rays->columns[crossX];
+        if (intersect_cabinet_box(player, span, ray->rayDirX, ray->rayDirY, &hitDist, &hitTexU) >= 0 &&
+            hitDist < highlightDepth) {
+            highlightDepth = hitDist;
+            highlight = span->index;
+        }
+    }
 
-                    // Darken side faces for depth perception
-                    if (hitFace == 1 || hitFace == 3) {
-                        color = blend_colors(color, pack_color(0, 0, 0), 0.3);
-                    }
+    for (int s = 0; s < visible; ++s) {
+        const CabinetSpan *span = &spans[s];
+        const CabinetEntry *entry = &game->cabinets[span->index];
+        int textureIndex = entry->texture_index % NUM_CABINET_TEXTURES;
+
+        for (int x = span->x0; x <= span->x1; ++x) {
+            double hitDist;
+            double hitTexU;
+            int hitFace = intersect_cabinet_box(player, span, rays->columns[x].rayDirX, rays->columns[x].rayDirY,
+                                                &hitDist, &hitTexU);
+            if (hitFace < 0 || hitDist >= zbuffer[x]) {
+                continue;
+            }
+            zbuffer[x] = hitDist;
+
+            // Calculate wall height on screen
+            int wallHeight = (int)(height / hitDist * CABINET_BOX_HEIGHT);
+            if (wallHeight < 1) wallHeight = 1;
+
+            int drawStartY = -wallHeight / 2 + height / 2;
+            int drawEndY = wallHeight / 2 + height / 2;
+            if (drawStartY < 0) drawStartY = 0;
+            if (drawEndY >= height) drawEndY = height - 1;
+
+            // Texture coordinates, at the mip level for this column's height
+            int mipLevel = texture_mip_level((double)TEX_SIZE / wallHeight);
+            const uint32_t *texture = mip_texture(&cabinet_mips, textureIndex, mipLevel);
+            int mipSize = TEX_SIZE >> mipLevel;
+            int texX = (int)(hitTexU * mipSize) & (mipSize - 1);
+
+            // Render vertical stripe
+            for (int y = drawStartY; y <= drawEndY; ++y) {
+                double texYf = (double)(y - drawStartY) / (double)wallHeight;
+                int texY = (int)(texYf * mipSize) & (mipSize - 1);
+                uint32_t color = texture[texY * mipSize + texX];
+
+                // Darken side faces for depth perception
+                if (hitFace == 1 || hitFace == 3) {
+                    color = blend_colors(color, pack_color(0, 0, 0), 0.3);
+                }
 
-                    // Highlight if targeted
-                    if (i == highlight) {
-                        color = blend_colors(color, pack_color(255, 255, 255), 0.35);
-                    }
+                // Highlight if targeted
+                if (span->index == highlight) {
+                    color = blend_colors(color, pack_color(255, 255, 255), 0.35);
+                }
 
-                    // Apply custom color aura if set
-                    if (entry->has_custom_color) {
-                        // Create aura effect on edges
-                        double normalizedY = (double)(y - drawStartY) / (double)wallHeight;
-                        bool isEdge = (normalizedY < 0.05 || normalizedY > 0.95 ||
-                                      hitTexU < 0.05 || hitTexU > 0.95);
-                        if (isEdge) {
-                            color = blend_colors(color, entry->custom_color, 0.7);
-                        } else {
-                            // Subtle glow even in the center
-                            color = blend_colors(color, entry->custom_color, 0.15);
-                        }
+                // Apply custom color aura if set
+                if (entry->has_custom_color) {
+                    // Create aura effect on edges
+                    double normalizedY = (double)(y - drawStartY) / (double)wallHeight;
+                    bool isEdge = (normalizedY < 0.05 || normalizedY > 0.95 ||
+                                  hitTexU < 0.05 || hitTexU > 0.95);
+                    if (isEdge) {
+                        color = blend_colors(color, entry->custom_color, 0.7);
+                    } else {
+                        // Subtle glow even in the center
+                        color = blend_colors(color, entry->custom_color, 0.15);
                     }
-
-                    draw_pixel(pixels, x, y, color);
                 }
+
+                pixels[y * rays->width + x] = color;
             }
         }
     }
     return highlight;
 }
 
-static uint32_t sample_display_pixel(const DisplayEntry *display, const Terminal *term,
-                                     double surface_u, double rel_height, int mapX, int mapY) {
-    const double border = 0.08;
-    uint32_t frameColor = pack_color(25, 35, 50);
+// Terminals are rasterized for wall displays at one texel per font pixel
+#define DISPLAY_BORDER 0.08
+
+typedef struct {
+    uint32_t *texels;  // (cols * 8) x (rows * 8), in physical row order
+    uint32_t row_versions[TERM_MAX_ROWS];
+    int cols;
+    int rows;
+    int row_offset;    // Physical row shown at the top, as in TermSnapshot
+    bool valid;
+} DisplayTexture;
+
+// Per-column display mapping; only the texel row varies down a wall column
+typedef struct {
+    const uint32_t *texels;  // NULL when the terminal is inactive (plain glass)
+    int texX;
+    int texWidth;
+    int rows;
+    int rowOffset;
+    bool inside;             // False when the column lies on the frame border
+} DisplayColumn;
+
+static DisplayTexture display_textures[MAX_TERMINALS];
+
+// Bumped whenever a display texture changes, so a cached scene knows to redraw
+static uint32_t display_version = 0;
+
+static void refresh_display_texture(DisplayTexture *tex, const TermSnapshot *term) {
+    if (!tex->texels || tex->cols != term->cols || tex->rows != term->rows) {
+        free(tex->texels);
+        tex->texels = malloc(sizeof(uint32_t) * (size_t)(term->cols * 8) * (size_t)(term->rows * 8));
+        tex->valid = false;
+        display_version++;
+        if (!tex->texels) {
+            tex->cols = 0;
+            tex->rows = 0;
+            return;
+        }
+        tex->cols = term->cols;
+        tex->rows = term->rows;
+    }
+
+    int texWidth = tex->cols * 8;
     uint32_t glassColor = pack_color(8, 12, 18);
+    for (int row = 0; row < tex->rows; row++) {
+        if (tex->valid && tex->row_versions[row] == term->row_versions[row]) {
+            continue;
+        }
+        const TermCell *cells = term_snapshot_phys_row(term, row);
+        for (int col = 0; col < tex->cols; col++) {
+            const TermAttr *attr = term_snapshot_attr(term, cells[col]);
+            const unsigned char *bitmap = glyph_bitmap(glyph_index(term_cell_char(cells[col])));
+            uint32_t onColor = blend_colors(attr->fg_pixel, glassColor, 0.2);
+            uint32_t offColor = blend_colors(attr->bg_pixel, glassColor, 0.5);
+
+            uint32_t *dst = &tex->texels[(size_t)row * 8 * texWidth + col * 8];
+            for (int gy = 0; gy < 8; gy++, dst += texWidth) {
+                for (int gx = 0; gx < 8; gx++) {
+                    dst[gx] = (bitmap[gy] & (1 << gx)) ? onColor : offColor;
+                }
+            }
+        }
+        tex->row_versions[row] = term->row_versions[row];
+        display_version++;
+    }
+    if (tex->row_offset != term->row_offset || !tex->valid) {
+        display_version++;
+    }
+    tex->row_offset = term->row_offset;
+    tex->valid = true;
+}
 
+// Bring every display-attached terminal texture up to date before the wall pass.
+// Inactive terminals drop their texture so the display shows bare glass.
+static void refresh_display_textures(const Game *game) {
+    if (game->skip_display_frames > 0) {
+        return;
+    }
+    pty_io_snapshot_lock();
+    for (int i = 0; i < game->display_count; i++) {
+        int termIndex = game->displays[i].terminal_index;
+        if (termIndex < 0 || termIndex >= MAX_TERMINALS) {
+            continue;
+        }
+        const TermSnapshot *snap = &game->terminals[termIndex].published;
+        if (!snap->active) {
+            if (display_textures[termIndex].valid) {
+                display_textures[termIndex].valid = false;
+                display_version++;
+            }
+            continue;
+        }
+        refresh_display_texture(&display_textures[termIndex], snap);
+    }
+    pty_io_snapshot_unlock();
+}
+
+static void prepare_display_column(DisplayColumn *column, const DisplayEntry *display, int termIndex,
+                                   double surface_u, int mapX, int mapY) {
     bool vertical_wall = fabs(display->normal_x) > fabs(display->normal_y);
     double axisTiles = vertical_wall ? (display->height > 0 ? display->height : 1) :
                                        (display->width > 0 ? display->width : 1);
@@ -215,184 +392,315 @@ static uint32_t sample_display_pixel(const DisplayEntry *display, const Terminal
     if (u < 0.0) u = 0.0;
     if (u > 1.0) u = 1.0;
 
+    column->inside = (u > DISPLAY_BORDER && u < 1.0 - DISPLAY_BORDER);
+    column->texels = NULL;
+    column->texX = 0;
+    column->texWidth = 0;
+    column->rows = 0;
+    column->rowOffset = 0;
+    if (termIndex < 0 || termIndex >= MAX_TERMINALS || !display_textures[termIndex].valid) {
+        return;
+    }
+    const DisplayTexture *tex = &display_textures[termIndex];
+    column->texels = tex->texels;
+    column->texWidth = tex->cols * 8;
+    column->rows = tex->rows;
+    column->rowOffset = tex->row_offset;
+
+    double screenU = (u - DISPLAY_BORDER) / (1.0 - DISPLAY_BORDER * 2.0);
+    if (screenU < 0.0) screenU = 0.0;
+    if (screenU > 1.0) screenU = 1.0;
+
+    double termXF = screenU * tex->cols;
+    int termX = clamp_int((int)termXF, 0, tex->cols - 1);
+    int glyphX = clamp_int((int)((termXF - termX) * 8.0), 0, 7);
+    column->texX = termX * 8 + glyphX;
+}
+
+static uint32_t sample_display_column(const DisplayColumn *column, double rel_height) {
     double v = rel_height;
     if (v < 0.0) v = 0.0;
     if (v > 1.0) v = 1.0;
 
-    bool inside_screen = (u > border && u < 1.0 - border && v > border && v < 1.0 - border);
-    if (!inside_screen) {
-        return frameColor;
+    if (!column->inside || v <= DISPLAY_BORDER || v >= 1.0 - DISPLAY_BORDER) {
+        return pack_color(25, 35, 50);  // Frame
     }
-
-    if (!term || !term->active) {
-        return glassColor;
+    if (!column->texels) {
+        return pack_color(8, 12, 18);   // Glass
     }
 
-    double screenU = (u - border) / (1.0 - border * 2.0);
-    double screenV = (v - border) / (1.0 - border * 2.0);
-    if (screenU < 0.0) screenU = 0.0;
-    if (screenU > 1.0) screenU = 1.0;
+    double screenV = (v - DISPLAY_BORDER) / (1.0 - DISPLAY_BORDER * 2.0);
     if (screenV < 0.0) screenV = 0.0;
     if (screenV > 1.0) screenV = 1.0;
 
-    double termXF = screenU * TERM_COLS;
-    double termYF = screenV * TERM_ROWS;
-    int termX = clamp_int((int)termXF, 0, TERM_COLS - 1);
-    int termY = clamp_int((int)termYF, 0, TERM_ROWS - 1);
-    double glyphXF = termXF - termX;
-    double glyphYF = termYF - termY;
-    int glyphX = clamp_int((int)(glyphXF * 8.0), 0, 7);
-    int glyphY = clamp_int((int)(glyphYF * 8.0), 0, 7);
-
-    const TermCell *cell = &term->cells[termY][termX];
-    unsigned char ch = (unsigned char)cell->ch;
-    if (ch < 32 || ch > 126) {
-        ch = ' ';
-    }
-
-    const unsigned char *bitmap = font8x8_basic[ch];
-    bool pixel_on = (bitmap[glyphY] & (1 << glyphX)) != 0;
-    uint32_t fg_color = ansi_colors[cell->fg_color & 0x0F];
-    uint32_t bg_color = ansi_colors[cell->bg_color & 0x0F];
-    uint32_t glyphColor = pixel_on ? fg_color : bg_color;
-
-    double glow = pixel_on ? 0.2 : 0.5;
-    return blend_colors(glyphColor, glassColor, glow);
+    double termYF = screenV * column->rows;
+    int termY = clamp_int((int)termYF, 0, column->rows - 1);
+    int glyphY = clamp_int((int)((termYF - termY) * 8.0), 0, 7);
+    int physRow = terminal_physical_row(column->rowOffset, column->rows, termY);
+    return column->texels[(size_t)(physRow * 8 + glyphY) * column->texWidth + column->texX];
 }
 
-void render_scene(const Game *game, uint32_t *pixels, double *zbuffer) {
-    if (!game->map.tiles || !game->door_state) {
-        return;  // Safety check for dynamic arrays
+// Rows per sky/floor tile and columns per wall tile handed to the job pool
+#define RENDER_ROW_TILE 20
+#define RENDER_COLUMN_TILE 32
+#define MAX_COLUMN_TILES (VIEW_MAX_WIDTH / RENDER_COLUMN_TILE + 4)
+
+typedef struct {
+    int x0;
+    int x1;
+    int displayHighlight;  // Crosshair display found while drawing this tile
+} ColumnTile;
+
+typedef struct {
+    const Game *game;
+    uint32_t *pixels;       // width x height
+    double *zbuffer;
+    const RayTable *rays;
+    int width;
+    int height;
+    ColumnTile tiles[MAX_COLUMN_TILES];
+    int tile_count;
+} SceneFrame;
+
+static RayTable ray_table;
+static JobPool *render_pool = NULL;
+
+// The 3D view, drawn at its own resolution and scaled to the window by the caller
+static uint32_t *view_pixels = NULL;
+static double *view_zbuffer = NULL;
+static int view_width = SCREEN_WIDTH;
+static int view_height = SCREEN_HEIGHT;
+static bool render_pool_initialized = false;
+
+// What the framebuffer currently holds from the last render_terminal call
+typedef struct {
+    const Terminal *term;
+    const uint32_t *pixels;
+    uint32_t row_versions[TERM_MAX_ROWS];  // Per physical row
+    int cols;
+    int rows;
+    int row_offset;
+    int cursor_x;
+    int cursor_phys_row;
+    bool cursor_drawn;
+    int view_offset;
+    int history_lines;
+    bool valid;
+} TerminalView;
+
+static TerminalView terminal_view;
+
+// What the 3D view (everything under the minimap and HUD) was drawn from
+typedef struct {
+    Player player;
+    const void *map;         // Map tiles, which change identity when a map loads
+    uint32_t world_version;
+    uint32_t display_version;
+    bool displays_hidden;    // skip_display_frames
+} WorldKey;
+
+// What the minimap and HUD were drawn from, besides the player
+typedef struct {
+    char hud_message[sizeof(((Game *)0)->hud_message)];
+    HudStatus hud_status;
+    int hud_bob;
+} OverlayKey;
+
+// Last scene: what the view buffer was drawn from, so a frame whose view didn't
+// change only redraws the HUD layer, and whether the HUD layer still holds it
+typedef struct {
+    WorldKey world_key;
+    OverlayKey overlay_key;
+    const uint32_t *hud;
+    int cabinet_highlight;   // Under the crosshair in the last view, for the label
+    int display_highlight;
+    bool world_valid;
+    bool frame_valid;
+} SceneCache;
+
+static SceneCache scene_cache;
+
+static JobPool *get_render_pool(void) {
+    if (!render_pool_initialized) {
+        render_pool_initialized = true;
+        int threads = job_pool_default_threads();
+        if (threads > 1) {
+            render_pool = job_pool_create(threads);
+        }
+#if DEBUG_MODE
+        printf("[DEBUG] renderer: using %d render thread(s)\n", job_pool_thread_count(render_pool));
+#endif
     }
+    return render_pool;
+}
 
-    const Player *player = &game->player;
-    double dirX = cos(player->angle);
-    double dirY = sin(player->angle);
-    double planeX = -sin(player->angle) * tan(player->fov / 2.0);
-    double planeY = cos(player->angle) * tan(player->fov / 2.0);
-
-    // Render sky first (Doom-style cylindrical panorama)
-    for (int y = 0; y < SCREEN_HEIGHT / 2; ++y) {
-        for (int x = 0; x < SCREEN_WIDTH; ++x) {
-            // Calculate horizontal angle for this column
-            double cameraX = 2.0 * x / (double)SCREEN_WIDTH - 1.0;
-            double columnAngle = atan2(dirY + planeY * cameraX, dirX + planeX * cameraX);
-
-            // Normalize angle to [0, 2*PI]
-            while (columnAngle < 0) columnAngle += 2.0 * M_PI;
-            while (columnAngle >= 2.0 * M_PI) columnAngle -= 2.0 * M_PI;
-
-            // Map angle to texture X coordinate (wrapping horizontally)
-            int skyX = (int)(columnAngle / (2.0 * M_PI) * SKY_TEXTURE_WIDTH) % SKY_TEXTURE_WIDTH;
-
-            // Map screen Y to texture Y coordinate - use only middle portion of texture to avoid stretching
-            // Map top of screen to middle of texture, stretch less
-            double skyV = (double)y / (double)(SCREEN_HEIGHT / 2);  // 0.0 at top, 1.0 at horizon
-            int skyY = (int)(skyV * SKY_TEXTURE_HEIGHT * 0.6);  // Only use 60% of texture height
-            if (skyY >= SKY_TEXTURE_HEIGHT) skyY = SKY_TEXTURE_HEIGHT - 1;
-
-            uint32_t skyColor = sky_texture[skyY * SKY_TEXTURE_WIDTH + skyX];
-            pixels[y * SCREEN_WIDTH + x] = skyColor;
-        }
-    }
-
-    double rayDirX0 = dirX - planeX;
-    double rayDirY0 = dirY - planeY;
-    double rayDirX1 = dirX + planeX;
-    double rayDirY1 = dirY + planeY;
-    for (int y = SCREEN_HEIGHT / 2; y < SCREEN_HEIGHT; ++y) {
-        double row = y - SCREEN_HEIGHT / 2.0;
+void renderer_shutdown(void) {
+    job_pool_destroy(render_pool);
+    render_pool = NULL;
+    render_pool_initialized = false;
+    for (int i = 0; i < MAX_TERMINALS; i++) {
+        free(display_textures[i].texels);
+        display_textures[i].texels = NULL;
+        display_textures[i].valid = false;
+    }
+    free(view_pixels);
+    free(view_zbuffer);
+    view_pixels = NULL;
+    view_zbuffer = NULL;
+    memset(&scene_cache, 0, sizeof(scene_cache));
+}
+
+bool renderer_set_view_size(int width, int height) {
+    width = clamp_int(width, VIEW_MIN_WIDTH, VIEW_MAX_WIDTH);
+    height = clamp_int(height, VIEW_MIN_HEIGHT, VIEW_MAX_HEIGHT);
+    if (view_pixels && width == view_width && height == view_height) {
+        return true;
+    }
+    uint32_t *pixels = calloc((size_t)width * height, sizeof(uint32_t));
+    double *zbuffer = malloc(sizeof(double) * (size_t)width);
+    if (!pixels || !zbuffer) {
+        free(pixels);
+        free(zbuffer);
+        return false;
+    }
+    free(view_pixels);
+    free(view_zbuffer);
+    view_pixels = pixels;
+    view_zbuffer = zbuffer;
+    view_width = width;
+    view_height = height;
+    scene_cache.world_valid = false;
+#if DEBUG_MODE
+    printf("[DEBUG] renderer: 3D view at %dx%d\n", width, height);
+#endif
+    return true;
+}
+
+const uint32_t *renderer_view(int *width, int *height) {
+    *width = view_width;
+    *height = view_height;
+    return view_pixels;
+}
+
+static void update_ray_table(RayTable *rays, const Player *player, int width, int height) {
+    if (rays->valid && rays->angle == player->angle && rays->fov == player->fov && rays->width == width &&
+        rays->height == height) {
+        return;
+    }
+    rays->width = width;
+    rays->height = height;
+    rays->angle = player->angle;
+    rays->fov = player->fov;
+    rays->dirX = cos(player->angle);
+    rays->dirY = sin(player->angle);
+    rays->planeX = -sin(player->angle) * tan(player->fov / 2.0);
+    rays->planeY = cos(player->angle) * tan(player->fov / 2.0);
+
+    for (int x = 0; x < width; ++x) {
+        ColumnRay *column = &rays->columns[x];
+        double cameraX = 2.0 * x / (double)width - 1.0;
+        column->rayDirX = rays->dirX + rays->planeX * cameraX;
+        column->rayDirY = rays->dirY + rays->planeY * cameraX;
+        column->deltaDistX = (column->rayDirX == 0) ? 1e30 : fabs(1.0 / column->rayDirX);
+        column->deltaDistY = (column->rayDirY == 0) ? 1e30 : fabs(1.0 / column->rayDirY);
+
+        double columnAngle = atan2(column->rayDirY, column->rayDirX);
+        // Normalize angle to [0, 2*PI]
+        while (columnAngle < 0) columnAngle += 2.0 * M_PI;
+        while (columnAngle >= 2.0 * M_PI) columnAngle -= 2.0 * M_PI;
+        // Map angle to texture X coordinate (wrapping horizontally)
+        column->skyX = (int)(columnAngle / (2.0 * M_PI) * SKY_TEXTURE_WIDTH) % SKY_TEXTURE_WIDTH;
+    }
+    rays->valid = true;
+}
+
+static void render_sky_rows(const SceneFrame *frame, int yStart, int yEnd) {
+    uint32_t *pixels = frame->pixels;
+    const ColumnRay *columns = frame->rays->columns;
+
+    // Render sky first (Doom-style cylindrical panorama); the column angle comes from the ray table
+    for (int y = yStart; y < yEnd; ++y) {
+        // Map screen Y to texture Y coordinate - use only middle portion of texture to avoid stretching
+        // Map top of screen to middle of texture, stretch less
+        double skyV = (double)y / (double)(frame->height / 2);  // 0.0 at top, 1.0 at horizon
+        int skyY = (int)(skyV * SKY_TEXTURE_HEIGHT * 0.6);  // Only use 60% of texture height
+        if (skyY >= SKY_TEXTURE_HEIGHT) skyY = SKY_TEXTURE_HEIGHT - 1;
+
+        const uint32_t *skyRow = &sky_texture[skyY * SKY_TEXTURE_WIDTH];
+        uint32_t *dst = &pixels[y * frame->width];
+        for (int x = 0; x < frame->width; ++x) {
+            dst[x] = skyRow[columns[x].skyX];
+        }
+    }
+}
+
+static void render_floor_rows(const SceneFrame *frame, int yStart, int yEnd) {
+    const Game *game = frame->game;
+    uint32_t *pixels = frame->pixels;
+    const RayTable *rays = frame->rays;
+    double rayDirX0 = rays->dirX - rays->planeX;
+    double rayDirY0 = rays->dirY - rays->planeY;
+    double rayDirX1 = rays->dirX + rays->planeX;
+    double rayDirY1 = rays->dirY + rays->planeY;
+    for (int y = yStart; y < yEnd; ++y) {
+        double row = y - frame->height / 2.0;
         if (row == 0.0) {
             row = 0.0001;
         }
-        double posZ = 0.5 * SCREEN_HEIGHT;
+        double posZ = 0.5 * frame->height;
         double rowDist = posZ / row;
-        double floorStepX = rowDist * (rayDirX1 - rayDirX0) / SCREEN_WIDTH;
-        double floorStepY = rowDist * (rayDirY1 - rayDirY0) / SCREEN_WIDTH;
+        double floorStepX = rowDist * (rayDirX1 - rayDirX0) / frame->width;
+        double floorStepY = rowDist * (rayDirY1 - rayDirY0) / frame->width;
         double floorX = game->player.x + rowDist * rayDirX0;
         double floorY = game->player.y + rowDist * rayDirY0;
-        for (int x = 0; x < SCREEN_WIDTH; ++x) {
-            int cellX = (int)floorX;
-            int cellY = (int)floorY;
-            double fracX = floorX - cellX;
-            double fracY = floorY - cellY;
-            int texX = (int)(fracX * TEX_SIZE) & (TEX_SIZE - 1);
-            int texY = (int)(fracY * TEX_SIZE) & (TEX_SIZE - 1);
-            uint32_t floorColor = pack_color(50, 40, 30);
-            if (cellX >= 0 && cellX < game->map.width && cellY >= 0 && cellY < game->map.height) {
-                int floorIdx = floor_index_for_char(game->map.tiles[cellY][cellX]);
-                floorColor = floor_textures[floorIdx][texY * TEX_SIZE + texX];
-            }
-            pixels[y * SCREEN_WIDTH + x] = floorColor;
-            floorX += floorStepX;
-            floorY += floorStepY;
-        }
+        // The mip level follows the larger footprint, across the row or to the
+        // next row, which grows faster with distance
+        double across = sqrt(floorStepX * floorStepX + floorStepY * floorStepY);
+        double along = rowDist / row;
+        int level = texture_mip_level((across > along ? across : along) * TEX_SIZE);
+        floorcast_span(&pixels[y * frame->width], frame->width, floorX, floorY, floorStepX, floorStepY, level);
     }
+}
 
-    int crossX = SCREEN_WIDTH / 2;
-    int crossY = SCREEN_HEIGHT / 2;
+static void render_wall_columns(const SceneFrame *frame, ColumnTile *tile) {
+    const Game *game = frame->game;
+    const Player *player = &game->player;
+    uint32_t *pixels = frame->pixels;
+    double *zbuffer = frame->zbuffer;
+    const ColumnRay *columns = frame->rays->columns;
+    int width = frame->width;
+    int height = frame->height;
+    int crossX = width / 2;
     int displayHighlight = -1;
     double displayHighlightDepth = 1e9;
 
-    for (int x = 0; x < SCREEN_WIDTH; ++x) {
-        double cameraX = 2.0 * x / (double)SCREEN_WIDTH - 1.0;
-        double rayDirX = dirX + planeX * cameraX;
-        double rayDirY = dirY + planeY * cameraX;
+    for (int x = tile->x0; x < tile->x1; ++x) {
+        double rayDirX = columns[x].rayDirX;
+        double rayDirY = columns[x].rayDirY;
 
-        int mapX = (int)player->x;
-        int mapY = (int)player->y;
         char hitTile = '1';
-
-        double deltaDistX = (rayDirX == 0) ? 1e30 : fabs(1.0 / rayDirX);
-        double deltaDistY = (rayDirY == 0) ? 1e30 : fabs(1.0 / rayDirY);
-
-        double sideDistX;
-        double sideDistY;
-        int stepX = (rayDirX < 0) ? -1 : 1;
-        int stepY = (rayDirY < 0) ? -1 : 1;
-
-        if (rayDirX < 0) {
-            sideDistX = (player->x - mapX) * deltaDistX;
-        } else {
-            sideDistX = (mapX + 1.0 - player->x) * deltaDistX;
-        }
-        if (rayDirY < 0) {
-            sideDistY = (player->y - mapY) * deltaDistY;
-        } else {
-            sideDistY = (mapY + 1.0 - player->y) * deltaDistY;
-        }
+        DdaState dda;
+        dda_begin(&dda, player->x, player->y, rayDirX, rayDirY, columns[x].deltaDistX, columns[x].deltaDistY);
 
         int hit = 0;
-        int side = 0;
         double doorOverlayDist = -1.0;
         int doorOverlayTexX = 0;
         while (!hit) {
-            if (sideDistX < sideDistY) {
-                sideDistX += deltaDistX;
-                mapX += stepX;
-                side = 0;
-            } else {
-                sideDistY += deltaDistY;
-                mapY += stepY;
-                side = 1;
-            }
-            if (mapX < 0 || mapX >= game->map.width || mapY < 0 || mapY >= game->map.height) {
+            dda_step(&dda);
+            if (dda.mapX < 0 || dda.mapX >= game->map.width || dda.mapY < 0 || dda.mapY >= game->map.height) {
                 hit = 1;
                 break;
             }
-            bool doorTile = (game->map.tiles[mapY][mapX] == 'D');
-            if (doorTile) {
-                int state = game->door_state[mapY][mapX];
+            char tile = game->map.tiles[dda.mapY][dda.mapX];
+            if (tile == 'D') {
+                int state = game->door_state[dda.mapY][dda.mapX];
                 if (state == 1) {
-                    double doorDist = (side == 0) ? (sideDistX - deltaDistX) : (sideDistY - deltaDistY);
-                    double doorWallX =
-                        (side == 0) ? player->y + doorDist * rayDirY : player->x + doorDist * rayDirX;
-                    doorWallX -= floor(doorWallX);
-                    int texX = (int)(doorWallX * TEX_SIZE);
-                    if (side == 0 && rayDirX > 0) {
+                    double doorDist = dda_distance(&dda);
+                    int texX = (int)(dda_wall_x(&dda) * TEX_SIZE);
+                    if (dda.side == 0 && rayDirX > 0) {
                         texX = TEX_SIZE - texX - 1;
                     }
-                    if (side == 1 && rayDirY < 0) {
+                    if (dda.side == 1 && rayDirY < 0) {
                         texX = TEX_SIZE - texX - 1;
                     }
                     if (doorOverlayDist < 0 || doorDist < doorOverlayDist) {
@@ -403,40 +711,32 @@ void render_scene(const Game *game, uint32_t *pixels, double *zbuffer) {
                 }
                 hitTile = 'D';
                 hit = 1;
-            } else if (tile_is_wall(game->map.tiles[mapY][mapX])) {
-                hitTile = game->map.tiles[mapY][mapX];
+            } else if (tile_is_wall(tile)) {
+                hitTile = tile;
                 hit = 1;
             }
         }
+        int mapX = dda.mapX;
+        int mapY = dda.mapY;
+        int side = dda.side;
 
-        double perpWallDist;
-        if (side == 0) {
-            perpWallDist = (sideDistX - deltaDistX);
-        } else {
-            perpWallDist = (sideDistY - deltaDistY);
-        }
+        double perpWallDist = dda_distance(&dda);
         if (perpWallDist <= 0.0001) {
             perpWallDist = 0.0001;
         }
         zbuffer[x] = perpWallDist;
 
-        int lineHeight = (int)(SCREEN_HEIGHT / perpWallDist);
-        int drawStart = -lineHeight / 2 + SCREEN_HEIGHT / 2;
+        int lineHeight = (int)(height / perpWallDist);
+        int drawStart = -lineHeight / 2 + height / 2;
         if (drawStart < 0) {
             drawStart = 0;
         }
-        int drawEnd = lineHeight / 2 + SCREEN_HEIGHT / 2;
-        if (drawEnd >= SCREEN_HEIGHT) {
-            drawEnd = SCREEN_HEIGHT - 1;
+        int drawEnd = lineHeight / 2 + height / 2;
+        if (drawEnd >= height) {
+            drawEnd = height - 1;
         }
 
-        double wallX;
-        if (side == 0) {
-            wallX = player->y + perpWallDist * rayDirY;
-        } else {
-            wallX = player->x + perpWallDist * rayDirX;
-        }
-        wallX -= floor(wallX);
+        double wallX = dda_wall_x(&dda);
 
         double surfaceU = wallX;
         if (side == 0 && rayDirX > 0) {
@@ -457,7 +757,7 @@ void render_scene(const Game *game, uint32_t *pixels, double *zbuffer) {
         bool renderDisplayWall = (hitTile == 'D' || hitTile == 'd') && game->skip_display_frames <= 0;
         int displayIndex = -1;
         const DisplayEntry *columnDisplay = NULL;
-        const Terminal *columnTerm = NULL;
+        DisplayColumn displayColumn = {NULL, 0, 0, 0, 0, false};
 
         if (renderDisplayWall) {
             displayIndex = find_display_at(game, mapX, mapY);
@@ -467,22 +767,29 @@ void render_scene(const Game *game, uint32_t *pixels, double *zbuffer) {
                     displayHighlightDepth = perpWallDist;
                     displayHighlight = displayIndex;
                 }
-                if (columnDisplay->terminal_index >= 0 && columnDisplay->terminal_index < MAX_TERMINALS) {
-                    columnTerm = &game->terminals[columnDisplay->terminal_index];
-                }
+                prepare_display_column(&displayColumn, columnDisplay, columnDisplay->terminal_index,
+                                       surfaceU, mapX, mapY);
             } else {
                 renderDisplayWall = false;
             }
         }
 
+        // Distant columns sample a smaller mip level instead of skipping texels
+        int mipLevel = texture_mip_level((double)TEX_SIZE / lineHeight);
+        const uint32_t *wallTexels = mip_texture(&wall_mips, texIndex, mipLevel);
+        int mipSize = TEX_SIZE >> mipLevel;
+        int mipTexX = texX >> mipLevel;
+
         for (int y = drawStart; y <= drawEnd; ++y) {
-            int d = y * 256 - SCREEN_HEIGHT * 128 + lineHeight * 128;
+            int d = y * 256 - height * 128 + lineHeight * 128;
             int texY = ((d * TEX_SIZE) / lineHeight) / 256;
-            uint32_t color = wall_textures[texIndex][texY * TEX_SIZE + texX];
+            // Odd view heights round the wall's top edge just above the texture
+            texY = texY < 0 ? 0 : (texY >= TEX_SIZE ? TEX_SIZE - 1 : texY);
+            uint32_t color = wallTexels[(texY >> mipLevel) * mipSize + mipTexX];
 
             if (renderDisplayWall && columnDisplay) {
                 double relY = (double)(y - drawStart) / (double)lineHeight;
-                color = sample_display_pixel(columnDisplay, columnTerm, surfaceU, relY, mapX, mapY);
+                color = sample_display_column(&displayColumn, relY);
                 if (displayHighlight == displayIndex && abs(x - crossX) <= 1) {
                     color = blend_colors(color, pack_color(255, 255, 120), 0.35);
                 }
@@ -497,157 +804,416 @@ void render_scene(const Game *game, uint32_t *pixels, double *zbuffer) {
                 double alpha = (t < 0.4) ? 0.65 : 0.35;
                 color = blend_colors(color, pack_color(140, 180, 220), alpha);
             }
-            pixels[y * SCREEN_WIDTH + x] = color;
+            pixels[y * width + x] = color;
         }
 
         if (doorOverlayDist > 0.0) {
-            int doorLineHeight = (int)(SCREEN_HEIGHT / doorOverlayDist);
-            int doorStart = -doorLineHeight / 2 + SCREEN_HEIGHT / 2;
+            int doorLineHeight = (int)(height / doorOverlayDist);
+            int doorStart = -doorLineHeight / 2 + height / 2;
             if (doorStart < 0) {
                 doorStart = 0;
             }
-            int doorEnd = doorLineHeight / 2 + SCREEN_HEIGHT / 2;
-            if (doorEnd >= SCREEN_HEIGHT) {
-                doorEnd = SCREEN_HEIGHT - 1;
+            int doorEnd = doorLineHeight / 2 + height / 2;
+            if (doorEnd >= height) {
+                doorEnd = height - 1;
             }
             for (int y = doorStart; y <= doorEnd; ++y) {
-                int d = y * 256 - SCREEN_HEIGHT * 128 + doorLineHeight * 128;
+                int d = y * 256 - height * 128 + doorLineHeight * 128;
                 int texY = ((d * TEX_SIZE) / doorLineHeight) / 256;
                 texY = texY < 0 ? 0 : (texY >= TEX_SIZE ? TEX_SIZE - 1 : texY);
                 uint32_t overlayColor = door_texture[texY * TEX_SIZE + doorOverlayTexX];
-                uint32_t base = pixels[y * SCREEN_WIDTH + x];
-                pixels[y * SCREEN_WIDTH + x] = blend_colors(base, overlayColor, 0.35);
+                uint32_t base = pixels[y * width + x];
+                pixels[y * width + x] = blend_colors(base, overlayColor, 0.35);
             }
         }
     }
 
-    int cabinetHighlight = render_cabinets(game, pixels, dirX, dirY, planeX, planeY, zbuffer);
+    tile->displayHighlight = displayHighlight;
+}
+
+static void background_tile_job(void *ctx, int index) {
+    const SceneFrame *frame = (const SceneFrame *)ctx;
+    int yStart = index * RENDER_ROW_TILE;
+    int yEnd = yStart + RENDER_ROW_TILE;
+    if (yEnd > frame->height) {
+        yEnd = frame->height;
+    }
+    int horizon = frame->height / 2;
+    if (yStart < horizon) {
+        uint64_t start = profiler_begin();
+        render_sky_rows(frame, yStart, yEnd < horizon ? yEnd : horizon);
+        profiler_end(PROF_SKY, start);
+    }
+    if (yEnd > horizon) {
+        uint64_t start = profiler_begin();
+        render_floor_rows(frame, yStart > horizon ? yStart : horizon, yEnd);
+        profiler_end(PROF_FLOOR, start);
+    }
+}
+
+static void wall_tile_job(void *ctx, int index) {
+    SceneFrame *frame = (SceneFrame *)ctx;
+    uint64_t start = profiler_begin();
+    render_wall_columns(frame, &frame->tiles[index]);
+    profiler_end(PROF_WALLS, start);
+}
+
+static void add_column_tiles(SceneFrame *frame, int x0, int x1) {
+    for (int x = x0; x < x1 && frame->tile_count < MAX_COLUMN_TILES; x += RENDER_COLUMN_TILE) {
+        ColumnTile *tile = &frame->tiles[frame->tile_count++];
+        tile->x0 = x;
+        tile->x1 = (x + RENDER_COLUMN_TILE < x1) ? x + RENDER_COLUMN_TILE : x1;
+        tile->displayHighlight = -1;
+    }
+}
+
+static WorldKey scene_world_key(const Game *game) {
+    WorldKey key;
+    key.player = game->player;
+    key.map = game->map.tiles;
+    key.world_version = game->world_version;
+    key.display_version = display_version;
+    key.displays_hidden = game->skip_display_frames > 0;
+    return key;
+}
+
+static bool world_key_equal(const WorldKey *a, const WorldKey *b) {
+    return a->player.x == b->player.x && a->player.y == b->player.y && a->player.angle == b->player.angle &&
+           a->player.fov == b->player.fov && a->map == b->map && a->world_version == b->world_version &&
+           a->display_version == b->display_version && a->displays_hidden == b->displays_hidden;
+}
+
+static OverlayKey scene_overlay_key(const Game *game) {
+    OverlayKey key;
+    memcpy(key.hud_message, game->hud_message, sizeof(key.hud_message));
+    key.hud_status = game->hud_status;
+    key.hud_bob = (int)game->hud_bob_offset;
+    return key;
+}
+
+static bool overlay_key_equal(const OverlayKey *a, const OverlayKey *b) {
+    return strcmp(a->hud_message, b->hud_message) == 0 &&
+           memcmp(&a->hud_status, &b->hud_status, sizeof(HudStatus)) == 0 && a->hud_bob == b->hud_bob;
+}
+
+// Sky, floor, walls and cabinets into the view buffer; notes what the
+// crosshair is on for the HUD label
+static void render_world(const Game *game) {
+    const Player *player = &game->player;
+    update_ray_table(&ray_table, player, view_width, view_height);
+    floorcast_prepare(&game->map);
+
+    SceneFrame frame;
+    frame.game = game;
+    frame.pixels = view_pixels;
+    frame.zbuffer = view_zbuffer;
+    frame.rays = &ray_table;
+    frame.width = view_width;
+    frame.height = view_height;
+
+    int crossX = view_width / 2;
+
+    // Display highlighting is resolved column by column across the three crosshair
+    // columns, so they share one tile to keep results identical to a serial pass.
+    frame.tile_count = 0;
+    add_column_tiles(&frame, 0, crossX - 1);
+    int crossTile = frame.tile_count;
+    add_column_tiles(&frame, crossX - 1, crossX + 2);
+    add_column_tiles(&frame, crossX + 2, view_width);
+
+    JobPool *pool = get_render_pool();
+    job_pool_run(pool, background_tile_job, &frame, (view_height + RENDER_ROW_TILE - 1) / RENDER_ROW_TILE);
+    job_pool_run(pool, wall_tile_job, &frame, frame.tile_count);
+
+    scene_cache.display_highlight = frame.tiles[crossTile].displayHighlight;
+
+    uint64_t cabinetStart = profiler_begin();
+    scene_cache.cabinet_highlight = render_cabinets(game, view_pixels, &ray_table, view_zbuffer);
+    profiler_end(PROF_CABINETS, cabinetStart);
+}
+
+static void draw_target_label(uint32_t *hud, int crossX, int crossY, const char *name, uint32_t color) {
+    if (!name || !*name) {
+        return;
+    }
+    int labelWidth = (int)strlen(name) * 8;
+    int labelX = crossX - labelWidth / 2;
+    if (labelX < 10) {
+        labelX = 10;
+    }
+    if (labelX + labelWidth >= SCREEN_WIDTH - 10) {
+        labelX = SCREEN_WIDTH - 10 - labelWidth;
+    }
+    draw_text(hud, labelX, crossY + 40, name, color);
+}
 
+// Crosshair and the highlighted object's name, at HUD resolution so they stay
+// sharp whatever the view is drawn at
+static void render_crosshair(const Game *game, uint32_t *hud) {
+    int crossX = SCREEN_WIDTH / 2;
+    int crossY = SCREEN_HEIGHT / 2;
     for (int i = -10; i <= 10; ++i) {
-        draw_pixel(pixels, crossX + i, crossY, pack_color(255, 255, 255));
-        draw_pixel(pixels, crossX, crossY + i, pack_color(255, 255, 255));
-    }
-    if (cabinetHighlight >= 0 && cabinetHighlight < game->cabinet_count) {
-        const CabinetEntry *entry = &game->cabinets[cabinetHighlight];
-        const char *name = get_cabinet_display_name(entry);
-        if (name && *name) {
-            int labelWidth = (int)strlen(name) * 8;
-            int labelX = crossX - labelWidth / 2;
-            if (labelX < 10) {
-                labelX = 10;
-            }
-            if (labelX + labelWidth >= SCREEN_WIDTH - 10) {
-                labelX = SCREEN_WIDTH - 10 - labelWidth;
-            }
-            draw_text(pixels, labelX, crossY + 40, name, pack_color(150, 255, 180));
-        }
-    } else if (displayHighlight >= 0 && displayHighlight < game->display_count) {
-        const DisplayEntry *entry = &game->displays[displayHighlight];
-        const char *name = entry->name;
-        if (name && *name) {
-            int labelWidth = (int)strlen(name) * 8;
-            int labelX = crossX - labelWidth / 2;
-            if (labelX < 10) {
-                labelX = 10;
-            }
-            if (labelX + labelWidth >= SCREEN_WIDTH - 10) {
-                labelX = SCREEN_WIDTH - 10 - labelWidth;
+        draw_pixel(hud, crossX + i, crossY, pack_color(255, 255, 255));
+        draw_pixel(hud, crossX, crossY + i, pack_color(255, 255, 255));
+    }
+    int cabinet = scene_cache.cabinet_highlight;
+    int display = scene_cache.display_highlight;
+    if (cabinet >= 0 && cabinet < game->cabinet_count) {
+        draw_target_label(hud, crossX, crossY, get_cabinet_display_name(&game->cabinets[cabinet]),
+                          pack_color(150, 255, 180));
+    } else if (display >= 0 && display < game->display_count) {
+        draw_target_label(hud, crossX, crossY, game->displays[display].name, pack_color(100, 200, 255));
+    }
+}
+
+int render_scene(const Game *game, uint32_t *hud) {
+    if (!game->map.tiles || !game->door_state) {
+        return 0;  // Safety check for dynamic arrays
+    }
+    if (!view_pixels && !renderer_set_view_size(view_width, view_height)) {
+        return 0;
+    }
+
+    // The scene overwrites the framebuffer the terminal view was retained in
+    terminal_view.valid = false;
+
+    refresh_display_textures(game);
+    WorldKey world_key = scene_world_key(game);
+    OverlayKey overlay_key = scene_overlay_key(game);
+    bool world_same = scene_cache.world_valid && world_key_equal(&world_key, &scene_cache.world_key);
+    bool overlay_same = overlay_key_equal(&overlay_key, &scene_cache.overlay_key);
+
+    int changed = 0;
+    if (!world_same) {
+        render_world(game);
+        scene_cache.world_key = world_key;
+        scene_cache.world_valid = true;
+        changed |= SCENE_VIEW_CHANGED;
+    }
+    // The minimap follows the player and the label the view, so any view
+    // change redraws the HUD too
+    if (changed || !overlay_same || !scene_cache.frame_valid || scene_cache.hud != hud || game->rename_mode) {
+        memset(hud, 0, sizeof(uint32_t) * SCREEN_WIDTH * SCREEN_HEIGHT);
+        render_crosshair(game, hud);
+        uint64_t start = profiler_begin();
+        render_minimap(hud, game);
+        profiler_end(PROF_MINIMAP, start);
+        start = profiler_begin();
+        render_hud(hud, game);
+        profiler_end(PROF_HUD, start);
+        scene_cache.overlay_key = overlay_key;
+        scene_cache.hud = hud;
+        changed |= SCENE_HUD_CHANGED;
+    }
+    // The rename dialog is drawn over the HUD afterwards, so while it's up
+    // every frame is drawn afresh and the layer never holds a clean HUD
+    scene_cache.frame_valid = !game->rename_mode;
+    return changed;
+}
+
+// Terminal cells are 8x8 font glyphs scaled up to 10x14 for readability
+#define TERM_CHAR_WIDTH 10
+#define TERM_CHAR_HEIGHT 14
+#define TERM_CURSOR_HEIGHT 2
+
+// Terminal mode layout: help bar and scrollback status above the grid, and
+// the largest grid that fits in the window around them
+#define TERM_SCREEN_TOP 36
+#define TERM_SCREEN_MARGIN 8
+#define TERM_WINDOW_COLS ((SCREEN_WIDTH - 2 * TERM_SCREEN_MARGIN) / TERM_CHAR_WIDTH)
+#define TERM_WINDOW_ROWS ((SCREEN_HEIGHT - TERM_SCREEN_TOP - TERM_SCREEN_MARGIN) / TERM_CHAR_HEIGHT)
+
+void renderer_terminal_grid(int *cols, int *rows) {
+    *cols = TERM_WINDOW_COLS;
+    *rows = TERM_WINDOW_ROWS;
+}
+
+// Glyphs pre-scaled into per-row bit masks (bit N = pixel column N), built
+// the first time each glyph is drawn
+static uint16_t term_glyph_masks[GLYPH_COUNT][TERM_CHAR_HEIGHT];
+static bool term_glyph_mask_built[GLYPH_COUNT];
+
+static const uint16_t *term_glyph_mask(uint32_t ch) {
+    int index = glyph_index(ch);
+    if (!term_glyph_mask_built[index]) {
+        const unsigned char *bitmap = glyph_bitmap(index);
+        for (int cy = 0; cy < TERM_CHAR_HEIGHT; cy++) {
+            unsigned char bits = bitmap[(cy * 8) / TERM_CHAR_HEIGHT];
+            uint16_t mask = 0;
+            for (int cx = 0; cx < TERM_CHAR_WIDTH; cx++) {
+                if (bits & (1 << ((cx * 8) / TERM_CHAR_WIDTH))) {
+                    mask |= (uint16_t)(1u << cx);
+                }
             }
-            draw_text(pixels, labelX, crossY + 40, name, pack_color(100, 200, 255));
+            term_glyph_masks[index][cy] = mask;
         }
+        term_glyph_mask_built[index] = true;
     }
+    return term_glyph_masks[index];
+}
+
+static void blit_term_cell(uint32_t *pixels, int px, int py, TermCell cell, const TermAttr *attr) {
+    if (px < 0 || py < 0 || px + TERM_CHAR_WIDTH > SCREEN_WIDTH ||
+        py + TERM_CHAR_HEIGHT > SCREEN_HEIGHT) {
+        return;
+    }
+
+    uint32_t colors[2] = {attr->bg_pixel, attr->fg_pixel};
+    const uint16_t *mask = term_glyph_mask(term_cell_char(cell));
 
-    render_minimap(pixels, game);
-    render_hud(pixels, game);
+    uint32_t *dst = &pixels[py * SCREEN_WIDTH + px];
+    for (int cy = 0; cy < TERM_CHAR_HEIGHT; cy++, dst += SCREEN_WIDTH) {
+        unsigned bits = mask[cy];
+        for (int cx = 0; cx < TERM_CHAR_WIDTH; cx++) {
+            dst[cx] = colors[(bits >> cx) & 1];
+        }
+    }
 }
 
 void render_terminal(const Terminal *term, uint32_t *pixels) {
-    if (!term || !term->active) {
+    if (!term) {
         return;
     }
 
-    // Calculate terminal position (centered on screen) - 50% bigger with proper scaling
-    int char_width = 10;  // Slightly bigger, properly spaced
-    int char_height = 14; // Taller for better readability
-    int term_pixel_width = TERM_COLS * char_width;
-    int term_pixel_height = TERM_ROWS * char_height;
-    int start_x = (SCREEN_WIDTH - term_pixel_width) / 2;
-    int start_y = (SCREEN_HEIGHT - term_pixel_height) / 2;
+    // Whatever happens below, the framebuffer no longer holds the scene
+    scene_cache.frame_valid = false;
 
-    // Clear screen to dark blue
-    for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
-        pixels[i] = 0xFF001020;
+    pty_io_snapshot_lock();
+    const TermSnapshot *snap = &term->published;
+    if (!snap->active || snap->cols > TERM_WINDOW_COLS || snap->rows > TERM_WINDOW_ROWS) {
+        pty_io_snapshot_unlock();
+        return;
     }
 
-    // Draw help bar at top
-    const char *help_text = "TERMINAL MODE - Press F1 to exit and return to game";
-    int help_x = (SCREEN_WIDTH - ((int)strlen(help_text) * 8)) / 2;
-    draw_text(pixels, help_x, 10, help_text, pack_color(255, 255, 100));
+    // Terminal centered on screen, below the help bar
+    int start_x = (SCREEN_WIDTH - snap->cols * TERM_CHAR_WIDTH) / 2;
+    int start_y = (SCREEN_HEIGHT - snap->rows * TERM_CHAR_HEIGHT) / 2;
+    if (start_y < TERM_SCREEN_TOP) {
+        start_y = TERM_SCREEN_TOP;
+    }
 
-    // Render each cell
-    for (int row = 0; row < TERM_ROWS; row++) {
-        for (int col = 0; col < TERM_COLS; col++) {
-            const TermCell *cell = &term->cells[row][col];
-            int px = start_x + col * char_width;
-            int py = start_y + row * char_height;
+    // Anything else drawn into the framebuffer since last time forces a full redraw
+    bool full_redraw = !terminal_view.valid || terminal_view.term != term ||
+                       terminal_view.pixels != pixels || terminal_view.cols != snap->cols ||
+                       terminal_view.rows != snap->rows;
+    if (full_redraw) {
+        // Clear screen to dark blue
+        for (int i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++) {
+            pixels[i] = 0xFF001020;
+        }
 
-            // Get colors
-            uint32_t bg_color = ansi_colors[cell->bg_color & 0x0F];
-            uint32_t fg_color = ansi_colors[cell->fg_color & 0x0F];
+        // Draw help bar at top
+        const char *help_text = "TERMINAL MODE - Press F1 to exit and return to game";
+        int help_x = (SCREEN_WIDTH - ((int)strlen(help_text) * 8)) / 2;
+        draw_text(pixels, help_x, 10, help_text, pack_color(255, 255, 100));
+    }
 
-            // Get character bitmap
-            unsigned char ch = (unsigned char)cell->ch;
-            if (ch < 32 || ch > 126) {
-                ch = ' ';
+    // Scrollback position, in the strip just above the terminal
+    if (full_redraw || snap->view_offset != terminal_view.view_offset ||
+        (snap->view_offset > 0 && snap->history_lines != terminal_view.history_lines)) {
+        int strip_y = start_y - 12;
+        for (int i = strip_y * SCREEN_WIDTH; i < (strip_y + 8) * SCREEN_WIDTH; i++) {
+            pixels[i] = 0xFF001020;
+        }
+        if (snap->view_offset > 0) {
+            char status[64];
+            snprintf(status, sizeof(status), "SCROLLBACK -%d/%d  (Shift+PgDn)",
+                     snap->view_offset, snap->history_lines);
+            draw_text(pixels, start_x, strip_y, status, pack_color(255, 255, 100));
+        }
+        terminal_view.view_offset = snap->view_offset;
+        terminal_view.history_lines = snap->history_lines;
+    }
+
+    // Scrolling rotated the row ring: shift the rows already on screen to
+    // match, then only the rows whose physical contents changed need drawing.
+    // Scroll regions rotate both ways, so shift whichever way wraps fewer
+    // rows around the ends; those rows are redrawn.
+    int wrapped_first = 0;
+    int wrapped_last = -1;
+    if (!full_redraw && snap->row_offset != terminal_view.row_offset) {
+        int shift = snap->row_offset - terminal_view.row_offset;
+        if (shift < 0) {
+            shift += snap->rows;
+        }
+        size_t line_bytes = sizeof(uint32_t) * snap->cols * TERM_CHAR_WIDTH;
+        int end_y = start_y + snap->rows * TERM_CHAR_HEIGHT;
+        if (shift * 2 <= snap->rows) {
+            int shift_pixels = shift * TERM_CHAR_HEIGHT;
+            for (int py = start_y; py < end_y - shift_pixels; py++) {
+                memmove(&pixels[py * SCREEN_WIDTH + start_x],
+                        &pixels[(py + shift_pixels) * SCREEN_WIDTH + start_x], line_bytes);
             }
-            const unsigned char *bitmap = font8x8_basic[ch];
-
-            // Render character scaled to fit char_width x char_height
-            // Use simple nearest-neighbor scaling
-            for (int cy = 0; cy < char_height; cy++) {
-                int src_y = (cy * 8) / char_height;  // Map to 0-7
-                for (int cx = 0; cx < char_width; cx++) {
-                    int src_x = (cx * 8) / char_width;  // Map to 0-7
-                    int screen_x = px + cx;
-                    int screen_y = py + cy;
-
-                    if (screen_x >= 0 && screen_x < SCREEN_WIDTH &&
-                        screen_y >= 0 && screen_y < SCREEN_HEIGHT) {
-
-                        bool pixel_set = bitmap[src_y] & (1 << src_x);
-                        uint32_t color = pixel_set ? fg_color : bg_color;
-                        pixels[screen_y * SCREEN_WIDTH + screen_x] = color;
-                    }
-                }
+            wrapped_first = snap->rows - shift;
+            wrapped_last = snap->rows - 1;
+        } else {
+            int shift_pixels = (snap->rows - shift) * TERM_CHAR_HEIGHT;
+            for (int py = end_y - 1; py >= start_y + shift_pixels; py--) {
+                memmove(&pixels[py * SCREEN_WIDTH + start_x],
+                        &pixels[(py - shift_pixels) * SCREEN_WIDTH + start_x], line_bytes);
             }
+            wrapped_first = 0;
+            wrapped_last = snap->rows - shift - 1;
+        }
+    }
+
+    // Versions are per physical row, so rows that merely moved stay clean
+    bool row_drawn[TERM_MAX_ROWS];
+    for (int row = 0; row < snap->rows; row++) {
+        int phys = terminal_physical_row(snap->row_offset, snap->rows, row);
+        row_drawn[row] = full_redraw || snap->row_versions[phys] != terminal_view.row_versions[phys] ||
+                         (row >= wrapped_first && row <= wrapped_last);
+        if (!row_drawn[row]) {
+            continue;
+        }
+        const TermCell *cells = term_snapshot_phys_row(snap, phys);
+        int py = start_y + row * TERM_CHAR_HEIGHT;
+        for (int col = 0; col < snap->cols; col++) {
+            blit_term_cell(pixels, start_x + col * TERM_CHAR_WIDTH, py, cells[col], term_snapshot_attr(snap, cells[col]));
+        }
+        terminal_view.row_versions[phys] = snap->row_versions[phys];
+    }
+    terminal_view.row_offset = snap->row_offset;
+
+    // Erase the previous cursor (wherever its row ended up) if that row was left untouched
+    if (!full_redraw && terminal_view.cursor_drawn) {
+        int col = terminal_view.cursor_x;
+        int row = terminal_view.cursor_phys_row - snap->row_offset;
+        if (row < 0) {
+            row += snap->rows;
+        }
+        if (!row_drawn[row]) {
+            TermCell cell = term_snapshot_phys_row(snap, terminal_view.cursor_phys_row)[col];
+            blit_term_cell(pixels, start_x + col * TERM_CHAR_WIDTH, start_y + row * TERM_CHAR_HEIGHT,
+                           cell, term_snapshot_attr(snap, cell));
         }
     }
 
     // Render cursor if visible
-    if (term->cursor_visible && term->cursor_x >= 0 && term->cursor_x < TERM_COLS &&
-        term->cursor_y >= 0 && term->cursor_y < TERM_ROWS) {
+    terminal_view.cursor_drawn = false;
+    if (snap->cursor_visible && snap->cursor_x >= 0 && snap->cursor_x < snap->cols &&
+        snap->cursor_y >= 0 && snap->cursor_y < snap->rows) {
 
-        int px = start_x + term->cursor_x * char_width;
-        int py = start_y + term->cursor_y * char_height;
+        int px = start_x + snap->cursor_x * TERM_CHAR_WIDTH;
+        int py = start_y + snap->cursor_y * TERM_CHAR_HEIGHT;
 
-        // Blinking cursor - draw underscore at bottom of cell
+        // Underscore at bottom of cell
         uint32_t cursor_color = 0xFFAAFFAA; // Light green cursor
-
-        int cursor_height = 2;  // Thin underscore
-        for (int cy = char_height - cursor_height; cy < char_height; cy++) {
-            for (int cx = 0; cx < char_width; cx++) {
-                int screen_x = px + cx;
-                int screen_y = py + cy;
-
-                if (screen_x >= 0 && screen_x < SCREEN_WIDTH &&
-                    screen_y >= 0 && screen_y < SCREEN_HEIGHT) {
-
-                    // Draw cursor as underline
-                    if (cy >= 6) {
-                        pixels[screen_y * SCREEN_WIDTH + screen_x] = cursor_color;
-                    }
-                }
+        for (int cy = TERM_CHAR_HEIGHT - TERM_CURSOR_HEIGHT; cy < TERM_CHAR_HEIGHT; cy++) {
+            uint32_t *dst = &pixels[(py + cy) * SCREEN_WIDTH + px];
+            for (int cx = 0; cx < TERM_CHAR_WIDTH; cx++) {
+                dst[cx] = cursor_color;
             }
         }
+        terminal_view.cursor_x = snap->cursor_x;
+        terminal_view.cursor_phys_row = terminal_physical_row(snap->row_offset, snap->rows, snap->cursor_y);
+        terminal_view.cursor_drawn = true;
     }
+
+    terminal_view.term = term;
+    terminal_view.pixels = pixels;
+    terminal_view.cols = snap->cols;
+    terminal_view.rows = snap->rows;
+    terminal_view.valid = true;
+    pty_io_snapshot_unlock();
 }
@@ -4,14 +4,58 @@
 #include "types.h"
 #include <stdint.h>
 
-// Main rendering function
-void render_scene(const Game *game, uint32_t *pixels, double *zbuffer);
+// Per-column camera rays, rebuilt only when the view angle or FOV changes
+typedef struct {
+    double rayDirX;
+    double rayDirY;
+    double deltaDistX;  // |1 / rayDirX|, 1e30 for axis-parallel rays
+    double deltaDistY;
+    int skyX;           // Sky panorama column for this ray
+} ColumnRay;
+
+typedef struct {
+    ColumnRay columns[VIEW_MAX_WIDTH];
+    int width;          // View columns the table was built for
+    int height;         // View rows, for projecting heights
+    double dirX;
+    double dirY;
+    double planeX;
+    double planeY;
+    double angle;
+    double fov;
+    bool valid;
+} RayTable;
+
+// render_scene results: which layers were redrawn since the last call
+#define SCENE_VIEW_CHANGED 1
+#define SCENE_HUD_CHANGED 2
+
+// Main rendering function. The 3D view goes to a buffer the renderer owns, at
+// the size set with renderer_set_view_size; crosshair, minimap and HUD go to
+// hud (SCREEN_WIDTH x SCREEN_HEIGHT, transparent elsewhere) to be drawn over
+// it. The view is only redrawn when the player, doors, cabinets or display
+// contents change, the HUD when anything it shows does; returns 0 when both
+// already hold exactly this frame from the previous call.
+int render_scene(const Game *game, uint32_t *hud);
+
+// Resolution of the 3D view, clamped to VIEW_MIN/MAX_*; applies from the next
+// render_scene. Returns false if the buffers can't be allocated (the previous
+// size stays in use).
+bool renderer_set_view_size(int width, int height);
+
+// The last rendered 3D view and its size
+const uint32_t *renderer_view(int *width, int *height);
+
+// Stop the render worker threads (started lazily by render_scene)
+void renderer_shutdown(void);
 
 // Sprite rendering functions
-int render_cabinets(const Game *game, uint32_t *pixels, double dirX, double dirY, double planeX, double planeY,
-                    double *zbuffer);
+int render_cabinets(const Game *game, uint32_t *pixels, const RayTable *rays, double *zbuffer);
 
 // Terminal rendering
 void render_terminal(const Terminal *term, uint32_t *pixels);
 
+// Largest terminal grid render_terminal can show in the window
+void renderer_terminal_grid(int *cols, int *rows);
+
 #endif // RENDERER_H
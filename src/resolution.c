@@ -0,0 +1,94 @@
+// Render resolution: how large the 3D view is drawn, and dynamic resolution
+#include "resolution.h"
+#include "types.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Frames that redraw the view are smoothed over about this many
+#define RESOLUTION_SMOOTHING 0.1
+// Step down above this share of the budget, back up below the lower one
+#define RESOLUTION_HIGH_WATER 0.9
+#define RESOLUTION_LOW_WATER 0.6
+// Frames to let the new size show in the average before the next change
+#define RESOLUTION_SETTLE_FRAMES 20
+#define RESOLUTION_STEP_DOWN 0.8
+#define RESOLUTION_STEP_UP 1.1
+
+double resolution_default_scale(void) {
+    const char *env = getenv("TSS_RENDER_SCALE");
+    if (env && *env) {
+        double requested = atof(env);
+        if (requested > 0.0) {
+            return requested < 0.25 ? 0.25 : (requested > 2.0 ? 2.0 : requested);
+        }
+    }
+    return 1.0;
+}
+
+bool resolution_default_dynamic(void) {
+    const char *env = getenv("TSS_DYNAMIC_RES");
+    return env && *env && atoi(env) != 0;
+}
+
+void resolution_init(Resolution *res, double scale, bool dynamic, int target_fps) {
+    res->scale = scale;
+    res->dynamic = dynamic;
+    res->budget_ms = 1000.0 / (target_fps > 0 ? target_fps : 60);
+    res->column_scale = 1.0;
+    res->average_ms = 0.0;
+    res->settle_frames = 0;
+}
+
+void resolution_view_size(const Resolution *res, int output_width, int output_height, int *width, int *height) {
+    double fit_x = (double)output_width / SCREEN_WIDTH;
+    double fit_y = (double)output_height / SCREEN_HEIGHT;
+    double fit = (fit_x < fit_y ? fit_x : fit_y) * res->scale;
+    if (fit <= 0.0) {
+        fit = res->scale;  // Minimized: keep the size the window would have
+    }
+    *width = (int)(SCREEN_WIDTH * fit * res->column_scale + 0.5);
+    *height = (int)(SCREEN_HEIGHT * fit + 0.5);
+}
+
+void resolution_set_dynamic(Resolution *res, bool dynamic) {
+    res->dynamic = dynamic;
+    res->column_scale = 1.0;
+    res->average_ms = 0.0;
+    res->settle_frames = 0;
+}
+
+bool resolution_frame_done(Resolution *res, double frame_ms) {
+    if (!res->dynamic) {
+        return false;
+    }
+    res->average_ms = res->average_ms > 0.0 ? res->average_ms + (frame_ms - res->average_ms) * RESOLUTION_SMOOTHING
+                                            : frame_ms;
+    if (res->settle_frames > 0) {
+        res->settle_frames--;
+        return false;
+    }
+
+    double scale = res->column_scale;
+    if (res->average_ms > res->budget_ms * RESOLUTION_HIGH_WATER) {
+        scale *= RESOLUTION_STEP_DOWN;
+    } else if (res->average_ms < res->budget_ms * RESOLUTION_LOW_WATER) {
+        scale *= RESOLUTION_STEP_UP;
+    }
+    if (scale < RESOLUTION_MIN_COLUMN_SCALE) {
+        scale = RESOLUTION_MIN_COLUMN_SCALE;
+    }
+    if (scale > 1.0) {
+        scale = 1.0;
+    }
+    if (scale == res->column_scale) {
+        return false;
+    }
+    // Most of a frame's cost is per column, so expect the time to follow
+    res->average_ms *= scale / res->column_scale;
+    res->column_scale = scale;
+    res->settle_frames = RESOLUTION_SETTLE_FRAMES;
+#if DEBUG_MODE
+    printf("[DEBUG] resolution: drawing %.0f%% of the columns\n", scale * 100.0);
+#endif
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef RESOLUTION_H
+#define RESOLUTION_H
+
+#include <stdbool.h>
+
+// Dynamic resolution never drops below this fraction of the view's columns
+#define RESOLUTION_MIN_COLUMN_SCALE 0.5
+
+typedef struct {
+    double scale;         // View size as a fraction of the window's pixels
+    bool dynamic;         // Drop columns while frames run over budget
+    double budget_ms;     // Frame time to stay within
+    double column_scale;  // Fraction of the columns currently drawn, 1 = all
+    double average_ms;    // Smoothed time of frames that redrew the view, 0 = none yet
+    int settle_frames;    // Frames to wait after a change before judging again
+} Resolution;
+
+// View scale from TSS_RENDER_SCALE (0.25 to 2), 1 if unset
+double resolution_default_scale(void);
+
+// Dynamic resolution from the start with TSS_DYNAMIC_RES=1
+bool resolution_default_dynamic(void);
+
+// target_fps sets the budget; 0 (uncapped) budgets for 60
+void resolution_init(Resolution *res, double scale, bool dynamic, int target_fps);
+
+// View size for an output_width x output_height drawable, letterboxed to the
+// SCREEN_WIDTH x SCREEN_HEIGHT aspect ratio
+void resolution_view_size(const Resolution *res, int output_width, int output_height, int *width, int *height);
+
+// Turn dynamic resolution on or off; off goes back to every column
+void resolution_set_dynamic(Resolution *res, bool dynamic);
+
+// Report a frame that redrew the 3D view and how long it took. Returns true
+// when the column count should change.
+bool resolution_frame_done(Resolution *res, double frame_ms);
+
+#endif // RESOLUTION_H
@@ -0,0 +1,305 @@
+// Terminal scrollback: a bounded ring of compressed lines in pooled blocks
+#include "scrollback.h"
+#include "termcell.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Encoded line: [size class][cell count lo][cell count hi] then runs of
+// [flags][n][fg][bg] followed by the n characters as UTF-8. Attributes are
+// stored by value since table indices change when a terminal compacts.
+// Colors take one byte, or three (R, G, B) when flags has RUN_FG_RGB or
+// RUN_BG_RGB set. Blank cells past the last visible one are not stored.
+#define LINE_HEADER 3
+#define RUN_HEADER_MAX 8
+#define RUN_MAX 255
+#define RUN_FG_RGB 0x40
+#define RUN_BG_RGB 0x80
+
+// Blocks of 16 << class bytes are carved from 64 KB slabs and recycled
+// through per-class free lists; anything bigger goes straight to malloc
+#define POOL_CLASSES 8
+#define POOL_MIN_BLOCK 16
+#define POOL_SLAB_SIZE (64 * 1024)
+#define POOL_LARGE 0xFF
+
+typedef struct PoolBlock {
+    struct PoolBlock *next;
+} PoolBlock;
+
+static PoolBlock *pool_free[POOL_CLASSES];
+
+static uint8_t *pool_alloc(size_t size) {
+    int cls = 0;
+    while (cls < POOL_CLASSES && ((size_t)POOL_MIN_BLOCK << cls) < size) {
+        cls++;
+    }
+    if (cls == POOL_CLASSES) {
+        uint8_t *block = malloc(size);
+        if (block) {
+            block[0] = POOL_LARGE;
+        }
+        return block;
+    }
+
+    if (!pool_free[cls]) {
+        // Slabs are never returned; history depth bounds how many are live
+        size_t block_size = (size_t)POOL_MIN_BLOCK << cls;
+        uint8_t *slab = malloc(POOL_SLAB_SIZE);
+        if (!slab) {
+            return NULL;
+        }
+        for (size_t off = 0; off + block_size <= POOL_SLAB_SIZE; off += block_size) {
+            PoolBlock *block = (PoolBlock *)(slab + off);
+            block->next = pool_free[cls];
+            pool_free[cls] = block;
+        }
+    }
+
+    PoolBlock *block = pool_free[cls];
+    pool_free[cls] = block->next;
+    uint8_t *bytes = (uint8_t *)block;
+    bytes[0] = (uint8_t)cls;
+    return bytes;
+}
+
+static void pool_release(uint8_t *bytes) {
+    if (!bytes) {
+        return;
+    }
+    if (bytes[0] == POOL_LARGE) {
+        free(bytes);
+        return;
+    }
+    int cls = bytes[0];
+    PoolBlock *block = (PoolBlock *)bytes;
+    block->next = pool_free[cls];
+    pool_free[cls] = block;
+}
+
+static int utf8_encode(uint32_t cp, uint8_t *out) {
+    if (cp < 0x80) {
+        out[0] = (uint8_t)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (uint8_t)(0xC0 | (cp >> 6));
+        out[1] = (uint8_t)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (uint8_t)(0xE0 | (cp >> 12));
+        out[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (uint8_t)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (uint8_t)(0xF0 | (cp >> 18));
+    out[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (uint8_t)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Only reads what utf8_encode wrote, so no validation is needed
+static uint32_t utf8_decode(const uint8_t **in) {
+    const uint8_t *p = *in;
+    uint32_t cp;
+    if (p[0] < 0x80) {
+        cp = p[0];
+        *in = p + 1;
+    } else if (p[0] < 0xE0) {
+        cp = ((uint32_t)(p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+        *in = p + 2;
+    } else if (p[0] < 0xF0) {
+        cp = ((uint32_t)(p[0] & 0x0F) << 12) | ((uint32_t)(p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+        *in = p + 3;
+    } else {
+        cp = ((uint32_t)(p[0] & 0x07) << 18) | ((uint32_t)(p[1] & 0x3F) << 12) |
+             ((uint32_t)(p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+        *in = p + 4;
+    }
+    return cp;
+}
+
+// A trailing cell can be dropped if it shows nothing but the default background
+static bool cell_is_blank(TermCell cell, const TermAttrTable *attrs) {
+    if (cell == TERM_CELL_BLANK) {
+        return true;
+    }
+    if (term_cell_char(cell) != ' ') {
+        return false;
+    }
+    const TermAttr *attr = &attrs->entries[term_cell_attr(cell)];
+    return attr->bg_color == TERM_COLOR_DEFAULT_BG && attr->attrs == 0;
+}
+
+static uint8_t *encode_color(uint8_t *out, TermColor color) {
+    if (color & TERM_COLOR_RGB) {
+        out[0] = (uint8_t)(color >> 16);
+        out[1] = (uint8_t)(color >> 8);
+        out[2] = (uint8_t)color;
+        return out + 3;
+    }
+    out[0] = (uint8_t)color;
+    return out + 1;
+}
+
+static TermColor decode_color(const uint8_t **in, bool rgb) {
+    const uint8_t *p = *in;
+    if (rgb) {
+        *in = p + 3;
+        return TERM_COLOR_RGB | ((TermColor)p[0] << 16) | ((TermColor)p[1] << 8) | p[2];
+    }
+    *in = p + 1;
+    return p[0];
+}
+
+// Scratch space for encoding, grown to the widest row seen
+static uint8_t *encode_buffer;
+static size_t encode_capacity;
+
+static uint8_t *encode_line(const TermCell *row, int cols, const TermAttrTable *attrs) {
+    int used = cols;
+    while (used > 0 && cell_is_blank(row[used - 1], attrs)) {
+        used--;
+    }
+
+    size_t worst = LINE_HEADER + (size_t)used * (RUN_HEADER_MAX + 4);
+    if (worst > encode_capacity) {
+        uint8_t *grown = realloc(encode_buffer, worst);
+        if (!grown) {
+            return NULL;
+        }
+        encode_buffer = grown;
+        encode_capacity = worst;
+    }
+
+    uint8_t *out = encode_buffer + LINE_HEADER;
+    for (int x = 0; x < used;) {
+        // Interned attributes are unique, so runs compare table indices
+        int index = term_cell_attr(row[x]);
+        int n = 1;
+        int limit = used - x < RUN_MAX ? used - x : RUN_MAX;
+        while (n < limit && term_cell_attr(row[x + n]) == index) {
+            n++;
+        }
+        const TermAttr *attr = &attrs->entries[index];
+        out[0] = attr->attrs;
+        if (attr->fg_color & TERM_COLOR_RGB) out[0] |= RUN_FG_RGB;
+        if (attr->bg_color & TERM_COLOR_RGB) out[0] |= RUN_BG_RGB;
+        out[1] = (uint8_t)n;
+        out = encode_color(out + 2, attr->fg_color);
+        out = encode_color(out, attr->bg_color);
+        for (int i = 0; i < n; i++) {
+            uint32_t ch = term_cell_char(row[x + i]);
+            if (ch < 0x80) {
+                *out++ = (uint8_t)ch;
+            } else {
+                out += utf8_encode(ch, out);
+            }
+        }
+        x += n;
+    }
+
+    size_t size = (size_t)(out - encode_buffer);
+    uint8_t *line = pool_alloc(size);
+    if (!line) {
+        return NULL;
+    }
+    memcpy(line + 1, encode_buffer + 1, size - 1);
+    line[1] = (uint8_t)(used & 0xFF);
+    line[2] = (uint8_t)(used >> 8);
+    return line;
+}
+
+static void decode_line(const uint8_t *line, TermCell *row, int cols, TermAttrTable *attrs) {
+    int used = line[1] | (line[2] << 8);
+    const uint8_t *in = line + LINE_HEADER;
+    int x = 0;
+    while (x < used) {
+        uint8_t flags = in[0];
+        int n = in[1];
+        in += 2;
+        TermAttr attr = {.attrs = flags & (uint8_t)~(RUN_FG_RGB | RUN_BG_RGB)};
+        attr.fg_color = decode_color(&in, (flags & RUN_FG_RGB) != 0);
+        attr.bg_color = decode_color(&in, (flags & RUN_BG_RGB) != 0);
+        int index = term_attr_intern(attrs, attr);
+        if (index < 0) {
+            index = term_attr_nearest(attrs, attr);  // Table full: the closest colors it has
+        }
+        for (int i = 0; i < n; i++, x++) {
+            uint32_t ch = utf8_decode(&in);
+            if (x < cols) {
+                row[x] = term_cell(ch, index);
+            }
+        }
+    }
+    if (used < cols) {
+        term_cells_fill(row + used, cols - used, TERM_CELL_BLANK);
+    }
+}
+
+int scrollback_default_depth(void) {
+    const char *env = getenv("TSS_SCROLLBACK_LINES");
+    if (env && *env) {
+        int requested = atoi(env);
+        if (requested >= 0) {
+            return requested > SCROLLBACK_MAX_LINES ? SCROLLBACK_MAX_LINES : requested;
+        }
+    }
+    return SCROLLBACK_DEFAULT_LINES;
+}
+
+void scrollback_init(Scrollback *sb, int capacity) {
+    memset(sb, 0, sizeof(*sb));
+    sb->capacity = capacity > 0 ? capacity : 0;
+}
+
+void scrollback_free(Scrollback *sb) {
+    if (sb->lines) {
+        for (int i = 0; i < sb->count; i++) {
+            pool_release(sb->lines[(sb->head + i) % sb->capacity]);
+        }
+        free(sb->lines);
+    }
+    // The depth stays: a terminal whose shell restarts keeps its scrollback
+    sb->lines = NULL;
+    sb->head = 0;
+    sb->count = 0;
+}
+
+void scrollback_push(Scrollback *sb, const TermCell *row, int cols, const TermAttrTable *attrs) {
+    if (sb->capacity <= 0) {
+        return;
+    }
+    if (!sb->lines) {
+        // Allocated on first use so terminals that never scroll cost nothing
+        sb->lines = calloc((size_t)sb->capacity, sizeof(*sb->lines));
+        if (!sb->lines) {
+            sb->capacity = 0;
+            return;
+        }
+    }
+
+    uint8_t *line = encode_line(row, cols, attrs);
+    if (!line) {
+        return;
+    }
+    if (sb->count == sb->capacity) {
+        pool_release(sb->lines[sb->head]);
+        sb->lines[sb->head] = line;
+        sb->head = (sb->head + 1) % sb->capacity;
+    } else {
+        sb->lines[(sb->head + sb->count) % sb->capacity] = line;
+        sb->count++;
+    }
+}
+
+bool scrollback_get(const Scrollback *sb, int age, TermCell *row, int cols, TermAttrTable *attrs) {
+    if (age < 0 || age >= sb->count) {
+        return false;
+    }
+    int index = (sb->head + sb->count - 1 - age) % sb->capacity;
+    decode_line(sb->lines[index], row, cols, attrs);
+    return true;
+}
@@ -0,0 +1,30 @@
+#ifndef SCROLLBACK_H
+#define SCROLLBACK_H
+
+#include "types.h"
+
+// Default history depth; TSS_SCROLLBACK_LINES overrides it (0 disables)
+#define SCROLLBACK_DEFAULT_LINES 10000
+#define SCROLLBACK_MAX_LINES 1000000
+
+int scrollback_default_depth(void);
+
+// Lines are stored run-length encoded by attributes with trailing blanks
+// trimmed, in blocks from a shared size-class pool. Not thread-safe: every
+// caller runs under the PTY I/O lock.
+void scrollback_init(Scrollback *sb, int capacity);
+
+// Drop every line but keep the configured depth, so the history can be
+// filled again
+void scrollback_free(Scrollback *sb);
+
+// Append a row that scrolled off the top, dropping the oldest line when full.
+// Cell attributes are resolved through attrs and stored by value.
+void scrollback_push(Scrollback *sb, const TermCell *row, int cols, const TermAttrTable *attrs);
+
+// Decode a line into row[0..cols), interning its attributes into attrs; age 0
+// is the most recently pushed line. Returns false (and leaves row untouched)
+// if there is no such line.
+bool scrollback_get(const Scrollback *sb, int age, TermCell *row, int cols, TermAttrTable *attrs);
+
+#endif // SCROLLBACK_H
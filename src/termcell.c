@@ -0,0 +1,256 @@
+// Attribute interning for packed terminal cells
+#include "termcell.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#define TERMCELL_SSE2 1
+#include <emmintrin.h>
+#else
+#define TERMCELL_SSE2 0
+#endif
+
+#define ATTR_TABLE_INITIAL 16
+
+// The 16 ANSI colors, in the game's CGA-style shades
+static const uint32_t ansi_colors[16] = {
+    0xFF000000, // 0: Black
+    0xFFAA0000, // 1: Red
+    0xFF00AA00, // 2: Green
+    0xFFAA5500, // 3: Yellow/Brown
+    0xFF0000AA, // 4: Blue
+    0xFFAA00AA, // 5: Magenta
+    0xFF00AAAA, // 6: Cyan
+    0xFFAAAAAA, // 7: White/Gray
+    0xFF555555, // 8: Bright Black/Gray
+    0xFFFF5555, // 9: Bright Red
+    0xFF55FF55, // 10: Bright Green
+    0xFFFFFF55, // 11: Bright Yellow
+    0xFF5555FF, // 12: Bright Blue
+    0xFFFF55FF, // 13: Bright Magenta
+    0xFF55FFFF, // 14: Bright Cyan
+    0xFFFFFFFF  // 15: Bright White
+};
+
+// 0xAARRGGBB for a color: xterm's 6x6x6 cube and gray ramp above the ANSI 16
+static uint32_t term_color_pixel(TermColor color) {
+    if (color & TERM_COLOR_RGB) {
+        return 0xFF000000u | (color & 0xFFFFFFu);
+    }
+    if (color < 16) {
+        return ansi_colors[color];
+    }
+    if (color < 232) {
+        static const uint8_t levels[6] = {0, 95, 135, 175, 215, 255};
+        int index = (int)color - 16;
+        return 0xFF000000u | ((uint32_t)levels[index / 36] << 16) | ((uint32_t)levels[index / 6 % 6] << 8) |
+               levels[index % 6];
+    }
+    uint32_t gray = 8 + 10 * ((color & 0xFF) - 232);
+    return 0xFF000000u | (gray << 16) | (gray << 8) | gray;
+}
+
+// Fill in the colors the renderers draw with
+static TermAttr attr_resolve(TermAttr attr) {
+    uint32_t fg = term_color_pixel(attr.fg_color);
+    uint32_t bg = term_color_pixel(attr.bg_color);
+    bool reverse = (attr.attrs & TERM_ATTR_REVERSE) != 0;
+    attr.fg_pixel = reverse ? bg : fg;
+    attr.bg_pixel = reverse ? fg : bg;
+    return attr;
+}
+
+// Colors are 25 bits each, so a key needs 58
+static uint64_t attr_key(TermAttr attr) {
+    return attr.fg_color | ((uint64_t)attr.bg_color << 25) | ((uint64_t)attr.attrs << 50);
+}
+
+static int attr_first_slot(const TermAttrTable *table, uint64_t key) {
+    uint32_t mixed = (uint32_t)(key ^ (key >> 29));
+    return (int)((mixed * 2654435761u) >> 12) & (table->capacity * 2 - 1);
+}
+
+static void attr_insert_slot(TermAttrTable *table, int index) {
+    int mask = table->capacity * 2 - 1;
+    int slot = attr_first_slot(table, attr_key(table->entries[index]));
+    while (table->slots[slot]) {
+        slot = (slot + 1) & mask;
+    }
+    table->slots[slot] = (uint16_t)(index + 1);
+}
+
+static bool attr_table_grow(TermAttrTable *table) {
+    int capacity = table->capacity ? table->capacity * 2 : ATTR_TABLE_INITIAL;
+    if (capacity > TERM_MAX_ATTRS) {
+        return false;
+    }
+    TermAttr *entries = realloc(table->entries, sizeof(TermAttr) * capacity);
+    if (!entries) {
+        return false;
+    }
+    table->entries = entries;
+    uint16_t *slots = calloc((size_t)capacity * 2, sizeof(uint16_t));
+    if (!slots) {
+        return false;
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+    for (int i = 0; i < table->count; i++) {
+        attr_insert_slot(table, i);
+    }
+    return true;
+}
+
+bool term_attr_table_init(TermAttrTable *table) {
+    memset(table, 0, sizeof(*table));
+    if (!attr_table_grow(table)) {
+        term_attr_table_free(table);
+        return false;
+    }
+    table->entries[0] = attr_resolve((TermAttr){.fg_color = TERM_COLOR_DEFAULT_FG, .bg_color = TERM_COLOR_DEFAULT_BG});
+    table->count = 1;
+    attr_insert_slot(table, 0);
+    return true;
+}
+
+void term_attr_table_free(TermAttrTable *table) {
+    free(table->entries);
+    free(table->slots);
+    table->entries = NULL;
+    table->slots = NULL;
+    table->count = 0;
+    table->capacity = 0;
+}
+
+int term_attr_intern(TermAttrTable *table, TermAttr attr) {
+    if (!table->slots) {
+        return -1;
+    }
+    uint64_t key = attr_key(attr);
+    int mask = table->capacity * 2 - 1;
+    for (int slot = attr_first_slot(table, key); table->slots[slot]; slot = (slot + 1) & mask) {
+        int index = table->slots[slot] - 1;
+        if (attr_key(table->entries[index]) == key) {
+            return index;
+        }
+    }
+
+    if (table->count == table->capacity && !attr_table_grow(table)) {
+        return -1;
+    }
+    int index = table->count++;
+    table->entries[index] = attr_resolve(attr);
+    attr_insert_slot(table, index);
+    return index;
+}
+
+#if TERMCELL_SSE2
+// fg_pixel and bg_pixel are compared with one 8-byte load
+_Static_assert(offsetof(TermAttr, bg_pixel) == offsetof(TermAttr, fg_pixel) + sizeof(uint32_t),
+               "TermAttr pixels must be adjacent");
+#else
+// Sum of the absolute channel differences of two 0xAARRGGBB pixels
+static int pixel_distance(uint32_t a, uint32_t b) {
+    return abs((int)((a >> 16) & 0xFF) - (int)((b >> 16) & 0xFF)) +
+           abs((int)((a >> 8) & 0xFF) - (int)((b >> 8) & 0xFF)) + abs((int)(a & 0xFF) - (int)(b & 0xFF));
+}
+#endif
+
+int term_attr_nearest(const TermAttrTable *table, TermAttr attr) {
+    TermAttr want = attr_resolve(attr);
+#if TERMCELL_SSE2
+    const __m128i want_pixels = _mm_set_epi32(0, 0, (int)want.bg_pixel, (int)want.fg_pixel);
+#endif
+    // Different flags cost more than any color difference
+    const int flag_penalty = 6 * 255 + 1;
+    int best = 0;
+    int best_distance = -1;
+    for (int i = 0; i < table->count; i++) {
+        const TermAttr *entry = &table->entries[i];
+#if TERMCELL_SSE2
+        // Both pixels' channel differences summed in one SAD; alpha is always 0xFF
+        int distance =
+            _mm_cvtsi128_si32(_mm_sad_epu8(_mm_loadl_epi64((const __m128i *)&entry->fg_pixel), want_pixels));
+#else
+        int distance = pixel_distance(entry->fg_pixel, want.fg_pixel) + pixel_distance(entry->bg_pixel, want.bg_pixel);
+#endif
+        if (entry->attrs != want.attrs) {
+            distance += flag_penalty;
+        }
+        if (best_distance < 0 || distance < best_distance) {
+            best = i;
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+typedef struct {
+    uint32_t first;
+    uint32_t last;
+} CharRange;
+
+// Combining marks and format characters that take no column of their own.
+// Covers the common scripts rather than all of Unicode.
+static const CharRange zero_width_ranges[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF},
+    {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A},
+    {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4},
+    {0x06E7, 0x06E8}, {0x06EA, 0x06ED}, {0x0900, 0x0902}, {0x093A, 0x093A},
+    {0x093C, 0x093C}, {0x0941, 0x0948}, {0x094D, 0x094D}, {0x0951, 0x0957},
+    {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x1AB0, 0x1AFF},
+    {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x202A, 0x202E}, {0x2060, 0x2064},
+    {0x20D0, 0x20FF}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF},
+    {0xE0100, 0xE01EF},
+};
+
+// East Asian wide and fullwidth characters, and emoji presented as wide
+static const CharRange wide_ranges[] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC},
+    {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615},
+    {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1},
+    {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5}, {0x26CE, 0x26CE},
+    {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+    {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B},
+    {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755},
+    {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF},
+    {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55}, {0x2E80, 0x303E},
+    {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF},
+    {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19},
+    {0xFE30, 0xFE6F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4},
+    {0x17000, 0x18AFF}, {0x1B000, 0x1B16F}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF},
+    {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F251}, {0x1F300, 0x1F64F},
+    {0x1F680, 0x1F6FF}, {0x1F7E0, 0x1F7EB}, {0x1F900, 0x1F9FF}, {0x1FA70, 0x1FAFF},
+    {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+};
+
+static bool char_in_ranges(uint32_t ch, const CharRange *ranges, int count) {
+    int lo = 0;
+    int hi = count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (ch < ranges[mid].first) {
+            hi = mid - 1;
+        } else if (ch > ranges[mid].last) {
+            lo = mid + 1;
+        } else {
+            return true;
+        }
+    }
+    return false;
+}
+
+int term_char_width(uint32_t ch) {
+    if (ch < 0x0300) {
+        return 1;
+    }
+    if (char_in_ranges(ch, zero_width_ranges, (int)(sizeof(zero_width_ranges) / sizeof(zero_width_ranges[0])))) {
+        return 0;
+    }
+    if (char_in_ranges(ch, wide_ranges, (int)(sizeof(wide_ranges) / sizeof(wide_ranges[0])))) {
+        return 2;
+    }
+    return 1;
+}
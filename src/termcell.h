@@ -0,0 +1,47 @@
+#ifndef TERMCELL_H
+#define TERMCELL_H
+
+#include "types.h"
+
+static inline TermCell term_cell(uint32_t ch, int attr) {
+    return (ch & TERM_CELL_CHAR_MASK) | ((uint32_t)attr << TERM_CELL_CHAR_BITS);
+}
+
+static inline uint32_t term_cell_char(TermCell cell) {
+    return cell & TERM_CELL_CHAR_MASK;
+}
+
+static inline int term_cell_attr(TermCell cell) {
+    return (int)(cell >> TERM_CELL_CHAR_BITS);
+}
+
+// Store one packed word across a run of cells (vectorized by the compiler)
+static inline void term_cells_fill(TermCell *cells, int count, TermCell value) {
+    for (int i = 0; i < count; i++) {
+        cells[i] = value;
+    }
+}
+
+// Blank in the default attribute (index 0: white on black, no flags)
+#define TERM_CELL_BLANK ((TermCell)' ')
+
+// The right half of a double-width character holds codepoint 0
+#define TERM_CELL_WIDE_SPACER 0
+
+// Columns a codepoint occupies: 0 for combining marks and zero-width
+// characters, 2 for East Asian wide and emoji, 1 otherwise
+int term_char_width(uint32_t ch);
+
+// Attribute interning. Tables start small and double up to TERM_MAX_ATTRS.
+bool term_attr_table_init(TermAttrTable *table);
+void term_attr_table_free(TermAttrTable *table);
+
+// Index of attr (by colors and flags; the pixel fields are filled in here),
+// adding it if new; -1 when the table is full or out of memory
+int term_attr_intern(TermAttrTable *table, TermAttr attr);
+
+// Index of the entry drawn closest to attr, preferring the same flags, for
+// when the table is full; 0 only if the table is empty
+int term_attr_nearest(const TermAttrTable *table, TermAttr attr);
+
+#endif // TERMCELL_H
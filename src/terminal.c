@@ -1,6 +1,10 @@
 // Terminal emulation module with PTY support
 #define _POSIX_C_SOURCE 200809L
 #include "terminal.h"
+#include "ptyio.h"
+#include "scrollback.h"
+#include "termcell.h"
+#include "profiler.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +15,13 @@
 #include <sys/wait.h>
 #include <sys/ioctl.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#define TERMINAL_SSE2 1
+#include <emmintrin.h>
+#else
+#define TERMINAL_SSE2 0
+#endif
+
 #if defined(__linux__)
 #include <pty.h>
 #include <utmp.h>
@@ -20,30 +31,246 @@
 #include <pty.h>
 #endif
 
+// Drawn in place of malformed UTF-8
+#define UTF8_REPLACEMENT 0xFFFD
+
+// Shared clock so a row version is never reused, even across terminal_init
+static uint32_t terminal_version_clock = 0;
+
+static void terminal_touch_rows(Terminal *term, int first, int last) {
+    if (first < 0) first = 0;
+    if (last >= term->rows) last = term->rows - 1;
+    if (first > last) {
+        return;
+    }
+    uint32_t version = ++terminal_version_clock;
+    for (int y = first; y <= last; y++) {
+        term->row_versions[terminal_physical_row(term->row_offset, term->rows, y)] = version;
+    }
+    term->content_version = version;
+}
+
+// Blank cell in the current colors, as erase operations leave behind
+static TermCell terminal_blank(const Terminal *term) {
+    return term_cell(' ', term->current_attr);
+}
+
+// Renumber the attribute table down to the entries the grid still uses
+static void terminal_compact_attrs(Terminal *term) {
+    TermAttrTable fresh;
+    if (!term_attr_table_init(&fresh)) {
+        return;
+    }
+    uint16_t remap[TERM_MAX_ATTRS];
+    memset(remap, 0xFF, sizeof(remap));
+    remap[0] = 0;
+    int count = term->cols * term->rows;
+    TermCell *grids[2] = {term->cells, term->inactive_cells};
+    for (int g = 0; g < 2; g++) {
+        TermCell *cells = grids[g];
+        for (int i = 0; cells && i < count; i++) {
+            TermCell cell = cells[i];
+            int index = term_cell_attr(cell);
+            if (remap[index] == 0xFFFF) {
+                int renumbered = term_attr_intern(&fresh, term->attr_table.entries[index]);
+                remap[index] = (uint16_t)(renumbered < 0 ? 0 : renumbered);
+            }
+            cells[i] = term_cell(term_cell_char(cell), remap[index]);
+        }
+    }
+    fresh.generation = term->attr_table.generation + 1;
+    term_attr_table_free(&term->attr_table);
+    term->attr_table = fresh;
+    terminal_touch_rows(term, 0, term->rows - 1);
+}
+
+// Intern the SGR state into current_attr. A full table is compacted down to
+// the attributes still on screen first; failing that, the closest interned
+// colors stand in. Compacting walks both grids, so when the screen really
+// does use most of the table it waits a screenful of misses before retrying.
+static void terminal_update_attr(Terminal *term) {
+    TermAttr attr = {.fg_color = term->current_fg, .bg_color = term->current_bg, .attrs = term->current_attrs};
+    int index = term_attr_intern(&term->attr_table, attr);
+    if (index < 0 && term->attr_table.count >= TERM_MAX_ATTRS) {
+        if (term->attr_compact_backoff > 0) {
+            term->attr_compact_backoff--;
+        } else {
+            terminal_compact_attrs(term);
+            index = term_attr_intern(&term->attr_table, attr);
+            if (term->attr_table.count > TERM_MAX_ATTRS * 3 / 4) {
+                term->attr_compact_backoff = term->cols * term->rows;
+            }
+        }
+    }
+    if (index < 0) {
+        index = term_attr_nearest(&term->attr_table, attr);
+    }
+    term->current_attr = (uint16_t)index;
+}
+
+// Free everything terminal_init and terminal_resize allocate
+static void terminal_release(Terminal *term) {
+    free(term->cells);
+    free(term->inactive_cells);
+    free(term->row_versions);
+    term->cells = NULL;
+    term->inactive_cells = NULL;
+    term->row_versions = NULL;
+    term->cols = 0;
+    term->rows = 0;
+
+    pty_io_snapshot_lock();
+    free(term->published.cells);
+    free(term->published.row_versions);
+    free(term->published.attrs);
+    term->published.cells = NULL;
+    term->published.row_versions = NULL;
+    term->published.attrs = NULL;
+    term->published.attr_count = 0;
+    term->published.attr_capacity = 0;
+    term->published.cols = 0;
+    term->published.rows = 0;
+    pty_io_snapshot_unlock();
+
+    scrollback_free(&term->history);
+    term_attr_table_free(&term->attr_table);
+    free(term->input_buffer);
+    term->input_buffer = NULL;
+    term->input_capacity = 0;
+    term->input_len = 0;
+}
+
 void terminal_init(Terminal *term) {
+    terminal_release(term);
     memset(term, 0, sizeof(*term));
     term->cursor_x = 0;
     term->cursor_y = 0;
     term->cursor_visible = true;
+    term->autowrap = true;
     term->saved_cursor_x = 0;
     term->saved_cursor_y = 0;
+    term->saved_fg = TERM_COLOR_DEFAULT_FG;
     term->pty_fd = -1;
     term->shell_pid = -1;
     term->active = false;
     term->parse_state = PARSE_NORMAL;
-    term->current_fg = 7;  // White
-    term->current_bg = 0;  // Black
+    term->current_fg = TERM_COLOR_DEFAULT_FG;  // White
+    term->current_bg = TERM_COLOR_DEFAULT_BG;  // Black
     term->current_attrs = 0;
+    term->current_attr = 0;
+    if (!term_attr_table_init(&term->attr_table)) {
+        fprintf(stderr, "terminal_init: out of memory\n");
+    }
+    scrollback_init(&term->history, scrollback_default_depth());
+
+    // Start at the default size, all cells blank
+    if (!terminal_resize(term, TERM_COLS, TERM_ROWS)) {
+        fprintf(stderr, "terminal_init: out of memory\n");
+    }
+}
+
+void terminal_destroy(Terminal *term) {
+    terminal_close(term);
+    terminal_release(term);
+}
+
+// Copy a grid (a ring at row_offset, in the current size) into a new
+// cols x rows one, starting from logical row first. Rows above first go to
+// history if asked. NULL grids come back blank; returns NULL if out of memory.
+static TermCell *terminal_regrid(Terminal *term, const TermCell *grid, int row_offset, int first,
+                                 int cols, int rows, bool history) {
+    TermCell *cells = malloc(sizeof(TermCell) * (size_t)cols * rows);
+    if (!cells) {
+        return NULL;
+    }
+    term_cells_fill(cells, cols * rows, TERM_CELL_BLANK);
+    if (!grid) {
+        return cells;
+    }
 
-    // Initialize all cells to blank
-    for (int y = 0; y < TERM_ROWS; y++) {
-        for (int x = 0; x < TERM_COLS; x++) {
-            term->cells[y][x].ch = ' ';
-            term->cells[y][x].fg_color = 7;
-            term->cells[y][x].bg_color = 0;
-            term->cells[y][x].attrs = 0;
+    for (int y = 0; history && y < first; y++) {
+        const TermCell *row = grid + (size_t)terminal_physical_row(row_offset, term->rows, y) * term->cols;
+        scrollback_push(&term->history, row, term->cols, &term->attr_table);
+    }
+    int keep = term->rows - first < rows ? term->rows - first : rows;
+    int width = term->cols < cols ? term->cols : cols;
+    for (int y = 0; y < keep; y++) {
+        const TermCell *row = grid + (size_t)terminal_physical_row(row_offset, term->rows, y + first) * term->cols;
+        memcpy(cells + (size_t)y * cols, row, sizeof(TermCell) * width);
+    }
+    return cells;
+}
+
+bool terminal_resize(Terminal *term, int cols, int rows) {
+    if (cols < 1) cols = 1;
+    if (cols > TERM_MAX_COLS) cols = TERM_MAX_COLS;
+    if (rows < 1) rows = 1;
+    if (rows > TERM_MAX_ROWS) rows = TERM_MAX_ROWS;
+    if (term->cells && cols == term->cols && rows == term->rows) {
+        return true;
+    }
+
+    // The main screen keeps the row its cursor is on (the saved one while the
+    // alternate screen is up); rows that no longer fit above it scroll into
+    // history. The alternate screen never feeds history.
+    int dropped = term->cells ? term->cursor_y + 1 - rows : 0;
+    int main_dropped = term->alt_screen ? term->saved_cursor_y + 1 - rows : 0;
+    if (dropped < 0) dropped = 0;
+    if (main_dropped < 0) main_dropped = 0;
+
+    // The grid that feeds history is copied last, once nothing else can fail
+    uint32_t *versions = calloc((size_t)rows, sizeof(uint32_t));
+    TermCell *cells = NULL;
+    TermCell *main_cells = NULL;
+    if (versions) {
+        cells = terminal_regrid(term, term->cells, term->row_offset, dropped, cols, rows, !term->alt_screen);
+    }
+    if (cells && term->alt_screen) {
+        main_cells = terminal_regrid(term, term->inactive_cells, term->inactive_row_offset, main_dropped,
+                                     cols, rows, true);
+    }
+    if (!cells || (term->alt_screen && !main_cells)) {
+        free(cells);
+        free(main_cells);
+        free(versions);
+        return false;
+    }
+
+    // An alternate screen that isn't shown is cleared before its next use anyway
+    free(term->cells);
+    free(term->inactive_cells);
+    free(term->row_versions);
+    term->cells = cells;
+    term->inactive_cells = main_cells;
+    term->row_versions = versions;
+    term->cols = cols;
+    term->rows = rows;
+    term->row_offset = 0;
+    term->inactive_row_offset = 0;
+    term->view_offset = 0;
+    term->scroll_top = 0;
+    term->scroll_bottom = rows - 1;
+    term->wrap_pending = false;
+
+    term->cursor_y -= dropped;
+    if (term->alt_screen) term->saved_cursor_y -= main_dropped;
+    if (term->cursor_x >= cols) term->cursor_x = cols - 1;
+    if (term->saved_cursor_x >= cols) term->saved_cursor_x = cols - 1;
+    if (term->saved_cursor_y >= rows) term->saved_cursor_y = rows - 1;
+    terminal_touch_rows(term, 0, rows - 1);
+
+    if (term->pty_fd >= 0) {
+        // The kernel sends SIGWINCH to the shell's foreground process group
+        struct winsize ws = {.ws_row = (unsigned short)rows, .ws_col = (unsigned short)cols};
+        if (ioctl(term->pty_fd, TIOCSWINSZ, &ws) != 0) {
+            perror("TIOCSWINSZ");
         }
+#if DEBUG_MODE
+        printf("[DEBUG] Shell %d resized to %dx%d\n", (int)term->shell_pid, cols, rows);
+#endif
     }
+    terminal_publish(term);
+    return true;
 }
 
 int terminal_spawn_shell(Terminal *term) {
@@ -51,9 +278,13 @@ int terminal_spawn_shell(Terminal *term) {
         return 0; // Already active
     }
 
+    if (!term->cells) {
+        return 0;
+    }
+
     struct winsize ws = {
-        .ws_row = TERM_ROWS,
-        .ws_col = TERM_COLS,
+        .ws_row = (unsigned short)term->rows,
+        .ws_col = (unsigned short)term->cols,
         .ws_xpixel = 0,
         .ws_ypixel = 0
     };
@@ -68,8 +299,13 @@ int terminal_spawn_shell(Terminal *term) {
 
     if (pid == 0) {
         // Child process - exec shell
-        setenv("TERM", "ansi", 1);
+        pty_io_child_reset();
+        setenv("TERM", "xterm-256color", 1);
         setenv("COLORTERM", "truecolor", 1);
+        // The parser decodes UTF-8; ask for it unless a locale is already set
+        if (!getenv("LC_ALL") && !getenv("LC_CTYPE") && !getenv("LANG")) {
+            setenv("LANG", "C.UTF-8", 1);
+        }
 
         // Try bash, then sh
         execl("/bin/bash", "bash", NULL);
@@ -90,6 +326,8 @@ int terminal_spawn_shell(Terminal *term) {
     if (flags >= 0) {
         fcntl(master_fd, F_SETFL, flags | O_NONBLOCK);
     }
+    pty_io_watch(term);
+    terminal_publish(term);
 
     return 1;
 }
@@ -100,6 +338,7 @@ void terminal_close(Terminal *term) {
     }
 
     if (term->pty_fd >= 0) {
+        pty_io_unwatch(term);
         close(term->pty_fd);
         term->pty_fd = -1;
     }
@@ -111,86 +350,560 @@ void terminal_close(Terminal *term) {
     }
 
     term->active = false;
+    term->view_offset = 0;
+    // Input the shell never read goes with it
+    term->input_head = 0;
+    term->input_len = 0;
+    term->input_blocked = false;
+    scrollback_free(&term->history);
+    terminal_publish(term);
+}
+
+// Append to the input ring, growing it (up to TERM_INPUT_MAX) as needed
+static bool terminal_queue_input(Terminal *term, const char *data, size_t len) {
+    if (len > TERM_INPUT_MAX - term->input_len) {
+        return false;
+    }
+    if (term->input_len + len > term->input_capacity) {
+        size_t capacity = term->input_capacity ? term->input_capacity : 4096;
+        while (capacity < term->input_len + len) {
+            capacity *= 2;
+        }
+        char *buffer = malloc(capacity);
+        if (!buffer) {
+            return false;
+        }
+        // Unwrap the ring into the new buffer
+        for (size_t i = 0; i < term->input_len; i++) {
+            buffer[i] = term->input_buffer[(term->input_head + i) % term->input_capacity];
+        }
+        free(term->input_buffer);
+        term->input_buffer = buffer;
+        term->input_capacity = capacity;
+        term->input_head = 0;
+    }
+
+    size_t tail = (term->input_head + term->input_len) % term->input_capacity;
+    size_t first = term->input_capacity - tail < len ? term->input_capacity - tail : len;
+    memcpy(term->input_buffer + tail, data, first);
+    memcpy(term->input_buffer, data + first, len - first);
+    term->input_len += len;
+    return true;
 }
 
-void terminal_write(Terminal *term, const char *data, size_t len) {
+bool terminal_write(Terminal *term, const char *data, size_t len) {
+    if (!term->active || term->pty_fd < 0) {
+        return false;
+    }
+
+    // Typing jumps back to the live screen, like xterm
+    terminal_scroll_view(term, -term->view_offset);
+    return terminal_queue_input(term, data, len);
+}
+
+int terminal_paste(Terminal *term, const char *text) {
+    if (!term->active || term->pty_fd < 0) {
+        return TERM_PASTE_INACTIVE;
+    }
+
+    static const char paste_start[] = "\033[200~";
+    static const char paste_end[] = "\033[201~";
+    size_t len = strlen(text);
+    char *data = malloc(len + 2 * (sizeof(paste_start) - 1));
+    if (!data) {
+        return TERM_PASTE_TOO_LARGE;
+    }
+    size_t n = 0;
+    if (term->bracketed_paste) {
+        memcpy(data, paste_start, sizeof(paste_start) - 1);
+        n += sizeof(paste_start) - 1;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '\r' && text[i + 1] == '\n') {
+            continue;  // CRLF: the LF becomes the CR
+        }
+        if (term->bracketed_paste && strncmp(text + i, paste_end, sizeof(paste_end) - 1) == 0) {
+            // Pasted text can't end the paste early and run as typed keys
+            i += sizeof(paste_end) - 2;
+            continue;
+        }
+        data[n++] = text[i] == '\n' ? '\r' : text[i];
+    }
+    if (term->bracketed_paste) {
+        memcpy(data + n, paste_end, sizeof(paste_end) - 1);
+        n += sizeof(paste_end) - 1;
+    }
+
+    bool queued = terminal_write(term, data, n);
+    free(data);
+    return queued ? TERM_PASTE_OK : TERM_PASTE_TOO_LARGE;
+}
+
+void terminal_flush_input(Terminal *term) {
     if (!term->active || term->pty_fd < 0) {
         return;
     }
 
-    ssize_t written = write(term->pty_fd, data, len);
-    if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
-        // Error writing, close terminal
-        terminal_close(term);
+    while (term->input_len > 0) {
+        size_t chunk = term->input_capacity - term->input_head;
+        if (chunk > term->input_len) {
+            chunk = term->input_len;
+        }
+        ssize_t written = write(term->pty_fd, term->input_buffer + term->input_head, chunk);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            // Error writing, close terminal
+            terminal_close(term);
+            return;
+        }
+        term->input_head = (term->input_head + (size_t)written) % term->input_capacity;
+        term->input_len -= (size_t)written;
+    }
+    if (term->input_len == 0) {
+        term->input_head = 0;
+    }
+
+    // A full PTY means the shell is behind: let the reactor finish the job
+    bool blocked = term->input_len > 0;
+    if (blocked != term->input_blocked) {
+        term->input_blocked = blocked;
+        pty_io_watch_output(term, blocked);
     }
 }
 
-void terminal_scroll_up(Terminal *term) {
-    // Move all rows up by one
-    for (int y = 0; y < TERM_ROWS - 1; y++) {
-        memcpy(term->cells[y], term->cells[y + 1], sizeof(TermCell) * TERM_COLS);
+// Push logical row y into history, keeping a scrolled-back view on the same
+// lines (the oldest may have been dropped)
+static void terminal_push_history(Terminal *term, int y) {
+    scrollback_push(&term->history, terminal_row(term, y), term->cols, &term->attr_table);
+    if (term->view_offset > 0) {
+        term->view_offset++;
+        if (term->view_offset > term->history.count) {
+            term->view_offset = term->history.count;
+        }
+    }
+}
+
+// Fill logical rows [first, last] with blanks in the current colors
+static void terminal_erase_rows(Terminal *term, int first, int last) {
+    TermCell blank = terminal_blank(term);
+    for (int y = first; y <= last; y++) {
+        term_cells_fill(terminal_row(term, y), term->cols, blank);
+    }
+    terminal_touch_rows(term, first, last);
+}
+
+// Scrolling a region either rotates the ring, as a full-screen scroll does,
+// and copies back the rows outside the region, or copies the rows inside it;
+// whichever moves fewer rows. The region keeps its physical rows when it is
+// rotated, so the renderer can shift it instead of redrawing.
+
+// Scroll logical rows [top, bottom] up by n, blanking n rows at the bottom.
+// With history set, rows leaving the top of the main screen go to scrollback.
+static void terminal_scroll_region_up(Terminal *term, int top, int bottom, int n, bool history) {
+    int height = bottom - top + 1;
+    if (n > height) n = height;
+    if (n <= 0) {
+        return;
+    }
+    if (history && top == 0 && !term->alt_screen) {
+        for (int y = 0; y < n; y++) {
+            terminal_push_history(term, y);
+        }
     }
 
-    // Clear bottom row
-    for (int x = 0; x < TERM_COLS; x++) {
-        term->cells[TERM_ROWS - 1][x].ch = ' ';
-        term->cells[TERM_ROWS - 1][x].fg_color = term->current_fg;
-        term->cells[TERM_ROWS - 1][x].bg_color = term->current_bg;
-        term->cells[TERM_ROWS - 1][x].attrs = term->current_attrs;
+    size_t row_bytes = sizeof(TermCell) * term->cols;
+    if (term->rows - height < height - n) {
+        // Logical row y now holds old row y + n. Rows above the region go
+        // first: sources of the top ones wrapped around into the rows below.
+        term->row_offset = terminal_physical_row(term->row_offset, term->rows, n);
+        for (int y = top - 1; y >= 0; y--) {
+            memcpy(terminal_row(term, y), terminal_row(term, (y - n + term->rows) % term->rows), row_bytes);
+        }
+        for (int y = term->rows - 1; y > bottom; y--) {
+            memcpy(terminal_row(term, y), terminal_row(term, y - n), row_bytes);
+        }
+        terminal_touch_rows(term, 0, top - 1);
+        terminal_touch_rows(term, bottom + 1, term->rows - 1);
+    } else {
+        for (int y = top; y + n <= bottom; y++) {
+            memcpy(terminal_row(term, y), terminal_row(term, y + n), row_bytes);
+        }
+        terminal_touch_rows(term, top, bottom - n);
     }
+    terminal_erase_rows(term, bottom - n + 1, bottom);
+}
+
+// Scroll logical rows [top, bottom] down by n, blanking n rows at the top
+static void terminal_scroll_region_down(Terminal *term, int top, int bottom, int n) {
+    int height = bottom - top + 1;
+    if (n > height) n = height;
+    if (n <= 0) {
+        return;
+    }
+
+    size_t row_bytes = sizeof(TermCell) * term->cols;
+    if (term->rows - height < height - n) {
+        // Logical row y now holds old row y - n. Rows below the region go
+        // first: sources of the bottom ones wrapped around into the rows above.
+        term->row_offset = terminal_physical_row(term->row_offset, term->rows, term->rows - n);
+        for (int y = bottom + 1; y < term->rows; y++) {
+            memcpy(terminal_row(term, y), terminal_row(term, (y + n) % term->rows), row_bytes);
+        }
+        for (int y = 0; y < top; y++) {
+            memcpy(terminal_row(term, y), terminal_row(term, y + n), row_bytes);
+        }
+        terminal_touch_rows(term, 0, top - 1);
+        terminal_touch_rows(term, bottom + 1, term->rows - 1);
+    } else {
+        for (int y = bottom; y - n >= top; y--) {
+            memcpy(terminal_row(term, y), terminal_row(term, y - n), row_bytes);
+        }
+        terminal_touch_rows(term, top + n, bottom);
+    }
+    terminal_erase_rows(term, top, top + n - 1);
+}
+
+void terminal_scroll_up(Terminal *term) {
+    terminal_scroll_region_up(term, term->scroll_top, term->scroll_bottom, 1, true);
 }
 
 void terminal_newline(Terminal *term) {
-    term->cursor_y++;
-    if (term->cursor_y >= TERM_ROWS) {
+    term->wrap_pending = false;
+    if (term->cursor_y == term->scroll_bottom) {
         terminal_scroll_up(term);
-        term->cursor_y = TERM_ROWS - 1;
+    } else if (term->cursor_y < term->rows - 1) {
+        term->cursor_y++;
+    }
+}
+
+// RI (ESC M): the mirror of a newline
+static void terminal_reverse_index(Terminal *term) {
+    term->wrap_pending = false;
+    if (term->cursor_y == term->scroll_top) {
+        terminal_scroll_region_down(term, term->scroll_top, term->scroll_bottom, 1);
+    } else if (term->cursor_y > 0) {
+        term->cursor_y--;
     }
 }
 
 void terminal_carriage_return(Terminal *term) {
     term->cursor_x = 0;
+    term->wrap_pending = false;
 }
 
 void terminal_clear(Terminal *term) {
-    for (int y = 0; y < TERM_ROWS; y++) {
-        for (int x = 0; x < TERM_COLS; x++) {
-            term->cells[y][x].ch = ' ';
-            term->cells[y][x].fg_color = term->current_fg;
-            term->cells[y][x].bg_color = term->current_bg;
-            term->cells[y][x].attrs = term->current_attrs;
-        }
-    }
+    // Every row is cleared, so the ring order doesn't matter
+    term_cells_fill(term->cells, term->cols * term->rows, terminal_blank(term));
+    terminal_touch_rows(term, 0, term->rows - 1);
     term->cursor_x = 0;
     term->cursor_y = 0;
+    term->wrap_pending = false;
+}
+
+// ICH: shift the rest of the cursor row right by n, blanking the gap
+static void terminal_insert_cells(Terminal *term, int n) {
+    int x = term->cursor_x;
+    if (n > term->cols - x) n = term->cols - x;
+    TermCell *row = terminal_row(term, term->cursor_y);
+    memmove(row + x + n, row + x, sizeof(TermCell) * (term->cols - x - n));
+    term_cells_fill(row + x, n, terminal_blank(term));
+    terminal_touch_rows(term, term->cursor_y, term->cursor_y);
+}
+
+// DCH: pull the rest of the cursor row left by n, blanking the end
+static void terminal_delete_cells(Terminal *term, int n) {
+    int x = term->cursor_x;
+    if (n > term->cols - x) n = term->cols - x;
+    TermCell *row = terminal_row(term, term->cursor_y);
+    memmove(row + x, row + x + n, sizeof(TermCell) * (term->cols - x - n));
+    term_cells_fill(row + term->cols - n, n, terminal_blank(term));
+    terminal_touch_rows(term, term->cursor_y, term->cursor_y);
 }
 
-void terminal_put_char(Terminal *term, char ch) {
-    if (term->cursor_y >= TERM_ROWS) {
-        term->cursor_y = TERM_ROWS - 1;
+// DEC special graphics for 0x5F-0x7E, as curses uses for line drawing
+static const uint16_t dec_graphics[32] = {
+    0x00A0, 0x25C6, 0x2592, 0x2409, 0x240C, 0x240D, 0x240A, 0x00B0,
+    0x00B1, 0x2424, 0x240B, 0x2518, 0x2510, 0x250C, 0x2514, 0x253C,
+    0x23BA, 0x23BB, 0x2500, 0x23BC, 0x23BD, 0x251C, 0x2524, 0x2534,
+    0x252C, 0x2502, 0x2264, 0x2265, 0x03C0, 0x2260, 0x00A3, 0x00B7,
+};
+
+void terminal_put_char(Terminal *term, uint32_t ch) {
+    int width = term_char_width(ch);
+    if (width == 0) {
+        return;
+    }
+    if (width > term->cols) {
+        width = 1;
+    }
+    if (term->charset_graphics && ch >= 0x5F && ch <= 0x7E) {
+        ch = dec_graphics[ch - 0x5F];
+    }
+
+    if (term->cursor_y >= term->rows) {
+        term->cursor_y = term->rows - 1;
+    }
+
+    // Wrap now if the last character filled the line (or a wide one won't fit)
+    if (term->wrap_pending || term->cursor_x + width > term->cols) {
+        if (term->autowrap) {
+            term->cursor_x = 0;
+            terminal_newline(term);
+        } else {
+            term->cursor_x = term->cols - width;
+        }
+    }
+
+    if (term->insert_mode) {
+        terminal_insert_cells(term, width);
+    }
+    TermCell *row = terminal_row(term, term->cursor_y);
+    row[term->cursor_x] = term_cell(ch, term->current_attr);
+    if (width == 2) {
+        row[term->cursor_x + 1] = term_cell(TERM_CELL_WIDE_SPACER, term->current_attr);
     }
+    terminal_touch_rows(term, term->cursor_y, term->cursor_y);
+    term->cursor_x += width;
 
-    // Auto-wrap to next line if we're at the edge
-    if (term->cursor_x >= TERM_COLS) {
-        term->cursor_x = 0;
-        terminal_newline(term);
+    // Like a VT100, stay on the last column until the next character arrives
+    if (term->cursor_x >= term->cols) {
+        term->cursor_x = term->cols - 1;
+        term->wrap_pending = term->autowrap;
     }
+}
 
-    if (term->cursor_y < TERM_ROWS && term->cursor_x < TERM_COLS) {
-        term->cells[term->cursor_y][term->cursor_x].ch = ch;
-        term->cells[term->cursor_y][term->cursor_x].fg_color = term->current_fg;
-        term->cells[term->cursor_y][term->cursor_x].bg_color = term->current_bg;
-        term->cells[term->cursor_y][term->cursor_x].attrs = term->current_attrs;
-        term->cursor_x++;
+// Write a run of printable characters, filling each row segment in one pass.
+// Wrapping matches terminal_put_char with autowrap on and insert mode and
+// the graphics charset off; terminal_feed only takes this path then.
+static void terminal_put_run(Terminal *term, const char *text, size_t len) {
+    TermCell attr = term_cell(0, term->current_attr);
 
-        // Auto-wrap when we hit the right edge
-        if (term->cursor_x >= TERM_COLS) {
+    while (len > 0) {
+        if (term->cursor_y >= term->rows) {
+            term->cursor_y = term->rows - 1;
+        }
+        if (term->wrap_pending) {
             term->cursor_x = 0;
             terminal_newline(term);
         }
+
+        int x = term->cursor_x;
+        size_t n = (size_t)(term->cols - x);
+        if (n > len) {
+            n = len;
+        }
+        TermCell *row = terminal_row(term, term->cursor_y) + x;
+        for (size_t i = 0; i < n; i++) {
+            row[i] = attr | (unsigned char)text[i];
+        }
+        terminal_touch_rows(term, term->cursor_y, term->cursor_y);
+        text += n;
+        len -= n;
+
+        term->cursor_x = x + (int)n;
+        if (term->cursor_x >= term->cols) {
+            term->cursor_x = term->cols - 1;
+            term->wrap_pending = true;
+        }
     }
 }
 
+// Length of the leading run of printable ASCII (0x20-0x7E)
+static size_t printable_run(const uint8_t *data, size_t len) {
+    size_t i = 0;
+#if TERMINAL_SSE2
+    const __m128i low = _mm_set1_epi8(31);
+    const __m128i high = _mm_set1_epi8(127);
+    for (; i + 16 <= len; i += 16) {
+        // Signed compares: bytes >= 0x80 are negative and fail the first test
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, low), _mm_cmplt_epi8(v, high));
+        unsigned mask = (unsigned)_mm_movemask_epi8(ok);
+        if (mask != 0xFFFF) {
+            return i + (size_t)__builtin_ctz(~mask);
+        }
+    }
+#endif
+    while (i < len && data[i] >= 32 && data[i] < 127) {
+        i++;
+    }
+    return i;
+}
+
+void terminal_feed(Terminal *term, const uint8_t *data, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        if (term->parse_state == PARSE_NORMAL && term->autowrap && !term->insert_mode &&
+            !term->charset_graphics) {
+            size_t run = printable_run(data + i, len - i);
+            if (run > 0) {
+                terminal_put_run(term, (const char *)data + i, run);
+                i += run;
+                continue;
+            }
+        }
+        terminal_parse_byte(term, data[i++]);
+    }
+}
+
+// Answer a DA or DSR query, queued behind any pending input and flushed
+// at the end of terminal_drain
+static void terminal_reply(Terminal *term, const char *reply) {
+    if (term->active && term->pty_fd >= 0) {
+        terminal_queue_input(term, reply, strlen(reply));
+    }
+}
+
+// DECSC / DECRC (ESC 7 / ESC 8, also CSI s / CSI u)
+static void terminal_save_cursor(Terminal *term) {
+    term->saved_cursor_x = term->cursor_x;
+    term->saved_cursor_y = term->cursor_y;
+    term->saved_fg = term->current_fg;
+    term->saved_bg = term->current_bg;
+    term->saved_attrs = term->current_attrs;
+    term->saved_charset_graphics = term->charset_graphics;
+}
+
+static void terminal_restore_cursor(Terminal *term) {
+    term->cursor_x = term->saved_cursor_x;
+    term->cursor_y = term->saved_cursor_y;
+    // Clamp to valid range
+    if (term->cursor_x < 0) term->cursor_x = 0;
+    if (term->cursor_x >= term->cols) term->cursor_x = term->cols - 1;
+    if (term->cursor_y < 0) term->cursor_y = 0;
+    if (term->cursor_y >= term->rows) term->cursor_y = term->rows - 1;
+    term->wrap_pending = false;
+    term->current_fg = term->saved_fg;
+    term->current_bg = term->saved_bg;
+    term->current_attrs = term->saved_attrs;
+    term->charset_graphics = term->saved_charset_graphics;
+    terminal_update_attr(term);
+}
+
+// Swap the main and alternate screens. The alternate grid is allocated the
+// first time it is shown; without memory for it the main screen stays up.
+static void terminal_set_alt_screen(Terminal *term, bool alt) {
+    if (alt == term->alt_screen) {
+        return;
+    }
+    if (!term->inactive_cells) {
+        term->inactive_cells = malloc(sizeof(TermCell) * (size_t)term->cols * term->rows);
+        if (!term->inactive_cells) {
+            return;
+        }
+        term_cells_fill(term->inactive_cells, term->cols * term->rows, TERM_CELL_BLANK);
+        term->inactive_row_offset = 0;
+    }
+    TermCell *cells = term->cells;
+    int row_offset = term->row_offset;
+    term->cells = term->inactive_cells;
+    term->row_offset = term->inactive_row_offset;
+    term->inactive_cells = cells;
+    term->inactive_row_offset = row_offset;
+    term->alt_screen = alt;
+    terminal_touch_rows(term, 0, term->rows - 1);
+}
+
+// DEC private modes (CSI ? n h / CSI ? n l)
+static void terminal_set_private_mode(Terminal *term, int mode, bool set) {
+    switch (mode) {
+        case 1: // DECCKM
+            term->app_cursor_keys = set;
+            break;
+        case 7: // DECAWM
+            term->autowrap = set;
+            term->wrap_pending = false;
+            break;
+        case 25: // Show/hide cursor
+            term->cursor_visible = set;
+            break;
+        case 2004: // Bracketed paste
+            term->bracketed_paste = set;
+            break;
+        case 47: // Alternate screen
+            terminal_set_alt_screen(term, set);
+            break;
+        case 1047: // Alternate screen, cleared on the way out
+            if (!set && term->alt_screen) {
+                terminal_erase_rows(term, 0, term->rows - 1);
+            }
+            terminal_set_alt_screen(term, set);
+            break;
+        case 1049: // Save the cursor and switch to a cleared alternate screen
+            if (set) {
+                if (!term->alt_screen) {
+                    terminal_save_cursor(term);
+                    terminal_set_alt_screen(term, true);
+                }
+                terminal_erase_rows(term, 0, term->rows - 1);
+            } else if (term->alt_screen) {
+                terminal_set_alt_screen(term, false);
+                terminal_restore_cursor(term);
+            }
+            break;
+    }
+}
+
+// RIS (ESC c): power-on state, keeping the shell, grid size and history
+static void terminal_reset(Terminal *term) {
+    terminal_set_alt_screen(term, false);
+    term->cursor_visible = true;
+    term->autowrap = true;
+    term->insert_mode = false;
+    term->app_cursor_keys = false;
+    term->bracketed_paste = false;
+    term->charset_graphics = false;
+    term->scroll_top = 0;
+    term->scroll_bottom = term->rows - 1;
+    term->saved_cursor_x = 0;
+    term->saved_cursor_y = 0;
+    term->saved_fg = TERM_COLOR_DEFAULT_FG;
+    term->saved_bg = TERM_COLOR_DEFAULT_BG;
+    term->saved_attrs = 0;
+    term->saved_charset_graphics = false;
+    term->parse_state = PARSE_NORMAL;
+    term->csi_buffer_len = 0;
+    term->current_fg = TERM_COLOR_DEFAULT_FG;
+    term->current_bg = TERM_COLOR_DEFAULT_BG;
+    term->current_attrs = 0;
+    term->current_attr = 0;
+    terminal_clear(term);
+}
+
+// The color after SGR 38/48 at params[*i]: 5;n or 2;r;g;b. Moves *i onto the
+// last parameter used; returns false (skipping the rest) if malformed.
+static bool terminal_sgr_color(Terminal *term, int *i, TermColor *color) {
+    int *params = term->ansi_params;
+    int remaining = term->ansi_param_count - *i - 1;
+    if (remaining >= 2 && params[*i + 1] == 5) {
+        int index = params[*i + 2];
+        *i += 2;
+        if (index < 0 || index > 255) {
+            return false;
+        }
+        *color = (TermColor)index;
+        return true;
+    }
+    if (remaining >= 4 && params[*i + 1] == 2) {
+        int r = params[*i + 2];
+        int g = params[*i + 3];
+        int b = params[*i + 4];
+        *i += 4;
+        if (r > 255 || g > 255 || b > 255) {
+            return false;
+        }
+        *color = TERM_COLOR_RGB | ((TermColor)r << 16) | ((TermColor)g << 8) | (TermColor)b;
+        return true;
+    }
+    *i = term->ansi_param_count;
+    return false;
+}
+
 void terminal_handle_csi(Terminal *term) {
     // Parse CSI sequence
     if (term->csi_buffer_len == 0) {
@@ -200,157 +913,234 @@ void terminal_handle_csi(Terminal *term) {
     char *buf = term->csi_buffer;
     char final = buf[term->csi_buffer_len - 1];
 
-    // Check for private mode sequences (start with '?')
+    // Check for private mode sequences (start with '?'). Other private
+    // markers (xterm's CSI > ... queries and settings) aren't supported.
     bool private_mode = (buf[0] == '?');
+    if (buf[0] == '>' || buf[0] == '<' || buf[0] == '=') {
+        return;
+    }
     char *param_start = private_mode ? buf + 1 : buf;
 
-    // Parse numeric parameters
+    // Parse numeric parameters, keeping empty ones as 0 and capping huge
+    // ones, so counts can be added to the cursor without overflowing
     term->ansi_param_count = 0;
     char *ptr = param_start;
     while (*ptr && term->ansi_param_count < 16) {
         if (*ptr >= '0' && *ptr <= '9') {
-            term->ansi_params[term->ansi_param_count] = atoi(ptr);
-            term->ansi_param_count++;
-            while (*ptr >= '0' && *ptr <= '9') ptr++;
+            int value = 0;
+            while (*ptr >= '0' && *ptr <= '9') {
+                if (value < TERM_MAX_PARAM) value = value * 10 + (*ptr - '0');
+                ptr++;
+            }
+            term->ansi_params[term->ansi_param_count++] = value < TERM_MAX_PARAM ? value : TERM_MAX_PARAM;
+        } else if (*ptr == ';' && (ptr == param_start || ptr[-1] == ';')) {
+            term->ansi_params[term->ansi_param_count++] = 0;
+            ptr++;
         } else {
             ptr++;
         }
     }
 
+    // Only SGR leaves the cursor alone; everything else cancels a pending wrap
+    if (final != 'm') {
+        term->wrap_pending = false;
+    }
+
     // Handle private mode sequences
     if (private_mode) {
-        switch (final) {
-            case 'h': // Set private mode
-                if (term->ansi_param_count > 0 && term->ansi_params[0] == 25) {
-                    // Show cursor
-                    term->cursor_visible = true;
-                }
-                return;
-            case 'l': // Reset private mode
-                if (term->ansi_param_count > 0 && term->ansi_params[0] == 25) {
-                    // Hide cursor
-                    term->cursor_visible = false;
-                }
-                return;
+        if (final == 'h' || final == 'l') {
+            for (int i = 0; i < term->ansi_param_count; i++) {
+                terminal_set_private_mode(term, term->ansi_params[i], final == 'h');
+            }
         }
+        return;
     }
 
+    // Count for movement and editing commands: missing or 0 means 1
+    int n = (term->ansi_param_count > 0 && term->ansi_params[0] > 0) ? term->ansi_params[0] : 1;
+
     // Handle commands
     switch (final) {
         case 'H': // Cursor position
         case 'f': {
             int row = (term->ansi_param_count > 0 && term->ansi_params[0] > 0) ? term->ansi_params[0] - 1 : 0;
             int col = (term->ansi_param_count > 1 && term->ansi_params[1] > 0) ? term->ansi_params[1] - 1 : 0;
-            term->cursor_y = row < TERM_ROWS ? row : TERM_ROWS - 1;
-            term->cursor_x = col < TERM_COLS ? col : TERM_COLS - 1;
+            term->cursor_y = row < term->rows ? row : term->rows - 1;
+            term->cursor_x = col < term->cols ? col : term->cols - 1;
             break;
         }
-        case 'A': { // Cursor up
-            int n = (term->ansi_param_count > 0 && term->ansi_params[0] > 0) ? term->ansi_params[0] : 1;
+        case 'A': { // Cursor up, stopping at the top margin from inside the region
+            int limit = term->cursor_y >= term->scroll_top ? term->scroll_top : 0;
             term->cursor_y -= n;
-            if (term->cursor_y < 0) term->cursor_y = 0;
+            if (term->cursor_y < limit) term->cursor_y = limit;
             break;
         }
-        case 'B': { // Cursor down
-            int n = (term->ansi_param_count > 0 && term->ansi_params[0] > 0) ? term->ansi_params[0] : 1;
+        case 'B': { // Cursor down, stopping at the bottom margin from inside the region
+            int limit = term->cursor_y <= term->scroll_bottom ? term->scroll_bottom : term->rows - 1;
             term->cursor_y += n;
-            if (term->cursor_y >= TERM_ROWS) term->cursor_y = TERM_ROWS - 1;
+            if (term->cursor_y > limit) term->cursor_y = limit;
             break;
         }
         case 'C': { // Cursor right
-            int n = (term->ansi_param_count > 0 && term->ansi_params[0] > 0) ? term->ansi_params[0] : 1;
             term->cursor_x += n;
-            if (term->cursor_x >= TERM_COLS) term->cursor_x = TERM_COLS - 1;
+            if (term->cursor_x >= term->cols) term->cursor_x = term->cols - 1;
             break;
         }
         case 'D': { // Cursor left
-            int n = (term->ansi_param_count > 0 && term->ansi_params[0] > 0) ? term->ansi_params[0] : 1;
             term->cursor_x -= n;
             if (term->cursor_x < 0) term->cursor_x = 0;
             break;
         }
+        case 'E': // Cursor next line (CNL)
+        case 'F': { // Cursor previous line (CPL)
+            term->cursor_y += final == 'E' ? n : -n;
+            if (term->cursor_y < 0) term->cursor_y = 0;
+            if (term->cursor_y >= term->rows) term->cursor_y = term->rows - 1;
+            term->cursor_x = 0;
+            break;
+        }
+        case 'G': // Cursor horizontal absolute (CHA, HPA)
+        case '`': {
+            term->cursor_x = n - 1 < term->cols ? n - 1 : term->cols - 1;
+            break;
+        }
+        case 'd': { // Line position absolute (VPA)
+            term->cursor_y = n - 1 < term->rows ? n - 1 : term->rows - 1;
+            break;
+        }
         case 'J': { // Erase in Display (ED)
-            int n = (term->ansi_param_count > 0) ? term->ansi_params[0] : 0;
-            if (n == 0) {
+            int mode = (term->ansi_param_count > 0) ? term->ansi_params[0] : 0;
+            TermCell blank = terminal_blank(term);
+            if (mode == 0) {
                 // Clear from cursor to end of screen
                 // Clear rest of current line
-                for (int x = term->cursor_x; x < TERM_COLS; x++) {
-                    term->cells[term->cursor_y][x].ch = ' ';
-                    term->cells[term->cursor_y][x].fg_color = term->current_fg;
-                    term->cells[term->cursor_y][x].bg_color = term->current_bg;
-                    term->cells[term->cursor_y][x].attrs = term->current_attrs;
+                if (term->cursor_x < term->cols) {
+                    term_cells_fill(terminal_row(term, term->cursor_y) + term->cursor_x,
+                                    term->cols - term->cursor_x, blank);
                 }
                 // Clear all lines below cursor
-                for (int y = term->cursor_y + 1; y < TERM_ROWS; y++) {
-                    for (int x = 0; x < TERM_COLS; x++) {
-                        term->cells[y][x].ch = ' ';
-                        term->cells[y][x].fg_color = term->current_fg;
-                        term->cells[y][x].bg_color = term->current_bg;
-                        term->cells[y][x].attrs = term->current_attrs;
-                    }
+                for (int y = term->cursor_y + 1; y < term->rows; y++) {
+                    term_cells_fill(terminal_row(term, y), term->cols, blank);
                 }
-            } else if (n == 1) {
+                terminal_touch_rows(term, term->cursor_y, term->rows - 1);
+            } else if (mode == 1) {
                 // Clear from cursor to beginning of screen
                 // Clear all lines above cursor
                 for (int y = 0; y < term->cursor_y; y++) {
-                    for (int x = 0; x < TERM_COLS; x++) {
-                        term->cells[y][x].ch = ' ';
-                        term->cells[y][x].fg_color = term->current_fg;
-                        term->cells[y][x].bg_color = term->current_bg;
-                        term->cells[y][x].attrs = term->current_attrs;
-                    }
+                    term_cells_fill(terminal_row(term, y), term->cols, blank);
                 }
                 // Clear from beginning of current line to cursor
-                for (int x = 0; x <= term->cursor_x && x < TERM_COLS; x++) {
-                    term->cells[term->cursor_y][x].ch = ' ';
-                    term->cells[term->cursor_y][x].fg_color = term->current_fg;
-                    term->cells[term->cursor_y][x].bg_color = term->current_bg;
-                    term->cells[term->cursor_y][x].attrs = term->current_attrs;
-                }
-            } else if (n == 2) {
+                term_cells_fill(terminal_row(term, term->cursor_y),
+                                term->cursor_x < term->cols ? term->cursor_x + 1 : term->cols, blank);
+                terminal_touch_rows(term, 0, term->cursor_y);
+            } else if (mode == 2) {
                 // Clear entire screen
                 terminal_clear(term);
             }
             break;
         }
         case 'K': { // Clear line
-            int n = (term->ansi_param_count > 0) ? term->ansi_params[0] : 0;
-            if (term->cursor_y < TERM_ROWS) {
-                if (n == 0) {
+            int mode = (term->ansi_param_count > 0) ? term->ansi_params[0] : 0;
+            if (term->cursor_y < term->rows) {
+                terminal_touch_rows(term, term->cursor_y, term->cursor_y);
+                TermCell *row = terminal_row(term, term->cursor_y);
+                TermCell blank = terminal_blank(term);
+                if (mode == 0) {
                     // Clear to end of line
-                    for (int x = term->cursor_x; x < TERM_COLS; x++) {
-                        term->cells[term->cursor_y][x].ch = ' ';
-                        term->cells[term->cursor_y][x].fg_color = term->current_fg;
-                        term->cells[term->cursor_y][x].bg_color = term->current_bg;
-                        term->cells[term->cursor_y][x].attrs = term->current_attrs;
+                    if (term->cursor_x < term->cols) {
+                        term_cells_fill(row + term->cursor_x, term->cols - term->cursor_x, blank);
                     }
-                } else if (n == 1) {
+                } else if (mode == 1) {
                     // Clear from beginning of line
-                    for (int x = 0; x <= term->cursor_x && x < TERM_COLS; x++) {
-                        term->cells[term->cursor_y][x].ch = ' ';
-                        term->cells[term->cursor_y][x].fg_color = term->current_fg;
-                        term->cells[term->cursor_y][x].bg_color = term->current_bg;
-                        term->cells[term->cursor_y][x].attrs = term->current_attrs;
-                    }
-                } else if (n == 2) {
+                    term_cells_fill(row, term->cursor_x < term->cols ? term->cursor_x + 1 : term->cols, blank);
+                } else if (mode == 2) {
                     // Clear entire line
-                    for (int x = 0; x < TERM_COLS; x++) {
-                        term->cells[term->cursor_y][x].ch = ' ';
-                        term->cells[term->cursor_y][x].fg_color = term->current_fg;
-                        term->cells[term->cursor_y][x].bg_color = term->current_bg;
-                        term->cells[term->cursor_y][x].attrs = term->current_attrs;
-                    }
+                    term_cells_fill(row, term->cols, blank);
+                }
+            }
+            break;
+        }
+        case 'L': // Insert lines (IL) / delete lines (DL): only inside the scroll region
+        case 'M': {
+            if (term->cursor_y >= term->scroll_top && term->cursor_y <= term->scroll_bottom) {
+                if (final == 'L') {
+                    terminal_scroll_region_down(term, term->cursor_y, term->scroll_bottom, n);
+                } else {
+                    terminal_scroll_region_up(term, term->cursor_y, term->scroll_bottom, n, false);
                 }
+                term->cursor_x = 0;
+            }
+            break;
+        }
+        case 'S': // Scroll up (SU)
+            terminal_scroll_region_up(term, term->scroll_top, term->scroll_bottom, n, true);
+            break;
+        case 'T': // Scroll down (SD)
+            terminal_scroll_region_down(term, term->scroll_top, term->scroll_bottom, n);
+            break;
+        case '@': // Insert characters (ICH)
+            terminal_insert_cells(term, n);
+            break;
+        case 'P': // Delete characters (DCH)
+            terminal_delete_cells(term, n);
+            break;
+        case 'X': { // Erase characters (ECH)
+            int count = n < term->cols - term->cursor_x ? n : term->cols - term->cursor_x;
+            term_cells_fill(terminal_row(term, term->cursor_y) + term->cursor_x, count, terminal_blank(term));
+            terminal_touch_rows(term, term->cursor_y, term->cursor_y);
+            break;
+        }
+        case 'r': { // Set scroll region (DECSTBM), then home the cursor
+            int top = (term->ansi_param_count > 0 && term->ansi_params[0] > 0) ? term->ansi_params[0] - 1 : 0;
+            int bottom = (term->ansi_param_count > 1 && term->ansi_params[1] > 0) ? term->ansi_params[1] - 1
+                                                                                 : term->rows - 1;
+            if (bottom >= term->rows) bottom = term->rows - 1;
+            if (top < bottom) {
+                term->scroll_top = top;
+                term->scroll_bottom = bottom;
+                term->cursor_x = 0;
+                term->cursor_y = 0;
+            }
+            break;
+        }
+        case 'h': // Set mode: only insert mode (IRM)
+        case 'l': {
+            for (int i = 0; i < term->ansi_param_count; i++) {
+                if (term->ansi_params[i] == 4) {
+                    term->insert_mode = final == 'h';
+                }
+            }
+            break;
+        }
+        case 'c': // Device attributes: a VT100 with advanced video
+            if (term->ansi_param_count == 0 || term->ansi_params[0] == 0) {
+                terminal_reply(term, "\033[?1;2c");
+            }
+            break;
+        case 'n': { // Device status report
+            int report = (term->ansi_param_count > 0) ? term->ansi_params[0] : 0;
+            if (report == 5) {
+                terminal_reply(term, "\033[0n");
+            } else if (report == 6) {
+                char reply[32];
+                snprintf(reply, sizeof(reply), "\033[%d;%dR", term->cursor_y + 1, term->cursor_x + 1);
+                terminal_reply(term, reply);
             }
             break;
         }
         case 'm': { // SGR - Set graphics rendition
+            if (term->ansi_param_count == 0) {
+                // No params means reset
+                term->current_fg = TERM_COLOR_DEFAULT_FG;
+                term->current_bg = TERM_COLOR_DEFAULT_BG;
+                term->current_attrs = 0;
+            }
             for (int i = 0; i < term->ansi_param_count; i++) {
                 int param = term->ansi_params[i];
                 if (param == 0) {
                     // Reset
-                    term->current_fg = 7;
-                    term->current_bg = 0;
+                    term->current_fg = TERM_COLOR_DEFAULT_FG;
+                    term->current_bg = TERM_COLOR_DEFAULT_BG;
                     term->current_attrs = 0;
                 } else if (param >= 30 && param <= 37) {
                     // Foreground color
@@ -364,35 +1154,43 @@ void terminal_handle_csi(Terminal *term) {
                 } else if (param >= 100 && param <= 107) {
                     // Bright background color
                     term->current_bg = param - 100 + 8;
+                } else if (param == 38 || param == 48) {
+                    // Extended color: 5;n from the 256-color palette or 2;r;g;b
+                    TermColor color;
+                    if (terminal_sgr_color(term, &i, &color)) {
+                        if (param == 38) {
+                            term->current_fg = color;
+                        } else {
+                            term->current_bg = color;
+                        }
+                    }
+                } else if (param == 39) {
+                    term->current_fg = TERM_COLOR_DEFAULT_FG;
+                } else if (param == 49) {
+                    term->current_bg = TERM_COLOR_DEFAULT_BG;
                 } else if (param == 1) {
-                    // Bold
-                    term->current_attrs |= 1;
+                    term->current_attrs |= TERM_ATTR_BOLD;
                 } else if (param == 4) {
-                    // Underline
-                    term->current_attrs |= 2;
+                    term->current_attrs |= TERM_ATTR_UNDERLINE;
+                } else if (param == 7) {
+                    term->current_attrs |= TERM_ATTR_REVERSE;
+                } else if (param == 22) {
+                    term->current_attrs &= (uint8_t)~TERM_ATTR_BOLD;
+                } else if (param == 24) {
+                    term->current_attrs &= (uint8_t)~TERM_ATTR_UNDERLINE;
+                } else if (param == 27) {
+                    term->current_attrs &= (uint8_t)~TERM_ATTR_REVERSE;
                 }
             }
-            if (term->ansi_param_count == 0) {
-                // No params means reset
-                term->current_fg = 7;
-                term->current_bg = 0;
-                term->current_attrs = 0;
-            }
+            terminal_update_attr(term);
             break;
         }
         case 's': { // Save cursor position
-            term->saved_cursor_x = term->cursor_x;
-            term->saved_cursor_y = term->cursor_y;
+            terminal_save_cursor(term);
             break;
         }
         case 'u': { // Restore cursor position
-            term->cursor_x = term->saved_cursor_x;
-            term->cursor_y = term->saved_cursor_y;
-            // Clamp to valid range
-            if (term->cursor_x < 0) term->cursor_x = 0;
-            if (term->cursor_x >= TERM_COLS) term->cursor_x = TERM_COLS - 1;
-            if (term->cursor_y < 0) term->cursor_y = 0;
-            if (term->cursor_y >= TERM_ROWS) term->cursor_y = TERM_ROWS - 1;
+            terminal_restore_cursor(term);
             break;
         }
     }
@@ -403,7 +1201,7 @@ void terminal_parse_byte(Terminal *term, uint8_t byte) {
         case PARSE_NORMAL:
             if (byte == '\033') {
                 term->parse_state = PARSE_ESC;
-            } else if (byte == '\n') {
+            } else if (byte == '\n' || byte == '\v' || byte == '\f') {
                 terminal_newline(term);
             } else if (byte == '\r') {
                 terminal_carriage_return(term);
@@ -411,41 +1209,130 @@ void terminal_parse_byte(Terminal *term, uint8_t byte) {
                 if (term->cursor_x > 0) {
                     term->cursor_x--;
                 }
+                term->wrap_pending = false;
             } else if (byte == '\t') {
-                // Tab - move to next tab stop (every 8 columns)
+                // Tab - move to next tab stop (every 8 columns), stopping at the last column
                 term->cursor_x = ((term->cursor_x / 8) + 1) * 8;
-                if (term->cursor_x >= TERM_COLS) {
-                    term->cursor_x = 0;
-                    terminal_newline(term);
+                if (term->cursor_x >= term->cols) {
+                    term->cursor_x = term->cols - 1;
                 }
+                term->wrap_pending = false;
             } else if (byte >= 32 && byte < 127) {
-                terminal_put_char(term, (char)byte);
+                terminal_put_char(term, byte);
+            } else if (byte >= 0xC2 && byte <= 0xF4) {
+                // UTF-8 lead byte: collect the continuation bytes
+                term->utf8_remaining = byte >= 0xF0 ? 3 : byte >= 0xE0 ? 2 : 1;
+                term->utf8_min = byte >= 0xF0 ? 0x10000 : byte >= 0xE0 ? 0x800 : 0x80;
+                term->utf8_codepoint = byte & (0x3F >> term->utf8_remaining);
+                term->parse_state = PARSE_UTF8;
+            } else if (byte >= 0x80) {
+                // Stray continuation byte or a lead that can't start valid UTF-8
+                terminal_put_char(term, UTF8_REPLACEMENT);
+            }
+            break;
+
+        case PARSE_UTF8:
+            if ((byte & 0xC0) != 0x80) {
+                // Truncated sequence: mark it, then handle the byte on its own
+                term->parse_state = PARSE_NORMAL;
+                terminal_put_char(term, UTF8_REPLACEMENT);
+                terminal_parse_byte(term, byte);
+                break;
+            }
+            term->utf8_codepoint = (term->utf8_codepoint << 6) | (byte & 0x3F);
+            if (--term->utf8_remaining == 0) {
+                uint32_t ch = term->utf8_codepoint;
+                bool valid = ch >= term->utf8_min && ch <= 0x10FFFF && (ch < 0xD800 || ch > 0xDFFF);
+                term->parse_state = PARSE_NORMAL;
+                terminal_put_char(term, valid ? ch : UTF8_REPLACEMENT);
             }
             break;
 
         case PARSE_ESC:
+            term->parse_state = PARSE_NORMAL;
             if (byte == '[') {
                 term->parse_state = PARSE_CSI;
                 term->csi_buffer_len = 0;
                 memset(term->csi_buffer, 0, sizeof(term->csi_buffer));
+            } else if (byte == ']' || byte == 'P' || byte == '_' || byte == '^' || byte == 'X') {
+                // OSC (titles, palette queries), DCS, APC, PM, SOS: not supported
+                term->parse_state = PARSE_STRING;
+            } else if (byte == '(') {
+                term->parse_state = PARSE_ESC_G0;
+            } else if (byte == ')' || byte == '*' || byte == '+' || byte == '#' || byte == '%') {
+                // Other charset designations and the like take one more byte
+                term->parse_state = PARSE_ESC_ARG;
+            } else if (byte == '7') {
+                terminal_save_cursor(term);
+            } else if (byte == '8') {
+                terminal_restore_cursor(term);
+            } else if (byte == 'D') {
+                // IND - Index
+                terminal_newline(term);
+            } else if (byte == 'E') {
+                // NEL - Next line
+                terminal_carriage_return(term);
+                terminal_newline(term);
+            } else if (byte == 'M') {
+                // RI - Reverse index
+                terminal_reverse_index(term);
             } else if (byte == 'c') {
                 // RIS - Reset to Initial State (ESC c)
-                terminal_init(term);
-                term->active = true;  // Keep terminal active
+                terminal_reset(term);
+            } else if (byte == '\033') {
+                term->parse_state = PARSE_ESC;
+            }
+            // Anything else (ESC = / ESC > keypad modes included) is ignored
+            break;
+
+        case PARSE_ESC_G0:
+            // Only G0 is ever shown (SO/SI aren't supported): ESC ( 0 selects
+            // line drawing, anything else (ESC ( B) plain ASCII
+            term->charset_graphics = (byte == '0');
+            term->parse_state = PARSE_NORMAL;
+            break;
+
+        case PARSE_ESC_ARG:
+            term->parse_state = PARSE_NORMAL;
+            break;
+
+        case PARSE_STRING:
+            if (byte == '\a') {
                 term->parse_state = PARSE_NORMAL;
-            } else {
-                // Unknown escape sequence, ignore
+            } else if (byte == '\033') {
+                term->parse_state = PARSE_STRING_ESC;
+            }
+            break;
+
+        case PARSE_STRING_ESC:
+            // ESC \ ends the string; any other ESC starts a new sequence
+            term->parse_state = PARSE_ESC;
+            if (byte == '\\') {
                 term->parse_state = PARSE_NORMAL;
+            } else {
+                terminal_parse_byte(term, byte);
             }
             break;
 
         case PARSE_CSI:
+            if (byte == '\033') {
+                // Aborted sequence: start over
+                term->parse_state = PARSE_ESC;
+                break;
+            }
+            if (byte < 0x20) {
+                // Control characters inside a sequence act immediately
+                term->parse_state = PARSE_NORMAL;
+                terminal_parse_byte(term, byte);
+                term->parse_state = PARSE_CSI;
+                break;
+            }
             if ((size_t)term->csi_buffer_len < sizeof(term->csi_buffer) - 1) {
                 term->csi_buffer[term->csi_buffer_len++] = byte;
             }
 
             // Check if this is a final byte
-            if ((byte >= 'A' && byte <= 'Z') || (byte >= 'a' && byte <= 'z')) {
+            if (byte >= 0x40 && byte <= 0x7E) {
                 terminal_handle_csi(term);
                 term->parse_state = PARSE_NORMAL;
             }
@@ -457,37 +1344,188 @@ void terminal_parse_byte(Terminal *term, uint8_t byte) {
     }
 }
 
-void terminal_update(Terminal *term) {
-    if (!term->active || term->pty_fd < 0) {
+// Match the snapshot's buffers to the grid size. Called with the snapshot lock held.
+static bool terminal_size_snapshot(const Terminal *term, TermSnapshot *snap) {
+    if (snap->cells && snap->cols == term->cols && snap->rows == term->rows) {
+        return true;
+    }
+    free(snap->cells);
+    free(snap->row_versions);
+    // Zeroed cells and versions never match the grid, so every row gets copied
+    snap->cells = calloc((size_t)term->cols * term->rows, sizeof(TermCell));
+    snap->row_versions = calloc((size_t)term->rows, sizeof(uint32_t));
+    snap->content_version = 0;
+    snap->row_offset = 0;
+    if (!snap->cells || !snap->row_versions) {
+        free(snap->cells);
+        free(snap->row_versions);
+        snap->cells = NULL;
+        snap->row_versions = NULL;
+        snap->cols = 0;
+        snap->rows = 0;
+        return false;
+    }
+    snap->cols = term->cols;
+    snap->rows = term->rows;
+    return true;
+}
+
+// Scrolled back: history lines fill the rows above the live screen. The
+// snapshot keeps its row_offset and only rows whose cells differ get a new
+// version, so the renderer redraws just what moved.
+static void terminal_publish_history(Terminal *term, TermSnapshot *snap) {
+    TermCell line[term->cols];
+    for (int y = 0; y < term->rows; y++) {
+        int age = term->view_offset - 1 - y;
+        if (age >= 0) {
+            scrollback_get(&term->history, age, line, term->cols, &term->attr_table);
+        } else {
+            memcpy(line, terminal_row(term, y - term->view_offset), sizeof(line));
+        }
+        int phys = terminal_physical_row(snap->row_offset, snap->rows, y);
+        TermCell *dst = snap->cells + (size_t)phys * snap->cols;
+        if (memcmp(dst, line, sizeof(line)) != 0) {
+            memcpy(dst, line, sizeof(line));
+            snap->row_versions[phys] = ++terminal_version_clock;
+            snap->content_version = snap->row_versions[phys];
+        }
+    }
+    snap->cursor_x = term->cursor_x;
+    snap->cursor_y = term->cursor_y + term->view_offset;
+    snap->cursor_visible = term->cursor_visible && snap->cursor_y < term->rows;
+}
+
+// Copy attribute table entries added since the last publish
+static bool terminal_publish_attrs(const Terminal *term, TermSnapshot *snap) {
+    const TermAttrTable *table = &term->attr_table;
+    if (snap->attr_capacity < table->count) {
+        TermAttr *attrs = realloc(snap->attrs, sizeof(TermAttr) * table->capacity);
+        if (!attrs) {
+            return false;
+        }
+        snap->attrs = attrs;
+        snap->attr_capacity = table->capacity;
+    }
+    if (snap->attr_count < table->count) {
+        memcpy(snap->attrs + snap->attr_count, table->entries + snap->attr_count,
+               sizeof(TermAttr) * (table->count - snap->attr_count));
+        snap->attr_count = table->count;
+    }
+    return true;
+}
+
+void terminal_publish(Terminal *term) {
+    TermSnapshot *snap = &term->published;
+    pty_io_snapshot_lock();
+    snap->publish_count++;
+    if (!terminal_size_snapshot(term, snap)) {
+        snap->active = false;
+        pty_io_snapshot_unlock();
         return;
     }
+    if (snap->attr_generation != term->attr_table.generation) {
+        // Compaction renumbered the table: recopy it and every row
+        memset(snap->cells, 0, sizeof(TermCell) * snap->cols * snap->rows);
+        memset(snap->row_versions, 0, sizeof(uint32_t) * snap->rows);
+        snap->content_version = 0;
+        snap->attr_count = 0;
+        snap->attr_generation = term->attr_table.generation;
+    }
+    if (term->view_offset > 0) {
+        terminal_publish_history(term, snap);
+    } else {
+        if (snap->content_version != term->content_version) {
+            size_t row_bytes = sizeof(TermCell) * term->cols;
+            for (int y = 0; y < term->rows; y++) {
+                if (snap->row_versions[y] != term->row_versions[y]) {
+                    memcpy(snap->cells + (size_t)y * term->cols, term->cells + (size_t)y * term->cols, row_bytes);
+                    snap->row_versions[y] = term->row_versions[y];
+                }
+            }
+            snap->content_version = term->content_version;
+        }
+        snap->row_offset = term->row_offset;
+        snap->cursor_x = term->cursor_x;
+        snap->cursor_y = term->cursor_y;
+        snap->cursor_visible = term->cursor_visible;
+    }
+    // After the rows: composing history may intern new attributes. Without
+    // its attribute table a snapshot can't be drawn.
+    bool attrs_published = terminal_publish_attrs(term, snap);
+    snap->active = term->active && attrs_published;
+    snap->view_offset = term->view_offset;
+    snap->history_lines = term->history.count;
+    pty_io_snapshot_unlock();
+}
 
-    // Check if shell has died
-    int status;
-    pid_t result = waitpid(term->shell_pid, &status, WNOHANG);
-    if (result != 0) {
-        // Shell has exited
-        terminal_close(term);
+void terminal_scroll_view(Terminal *term, int lines) {
+    int offset = term->view_offset + lines;
+    if (offset > term->history.count) {
+        offset = term->history.count;
+    }
+    if (offset < 0) {
+        offset = 0;
+    }
+    if (offset == term->view_offset) {
         return;
     }
 
-    // Read from PTY
-    ssize_t nread = read(term->pty_fd, term->read_buffer, sizeof(term->read_buffer) - 1);
+    term->view_offset = offset;
+    if (offset == 0) {
+        // The snapshot rows still hold history; give every live row a new version
+        terminal_touch_rows(term, 0, term->rows - 1);
+    }
+    terminal_publish(term);
+}
 
-    if (nread < 0) {
-        if (errno != EAGAIN && errno != EWOULDBLOCK) {
-            // Error reading, close terminal
-            terminal_close(term);
+bool terminal_drain(Terminal *term, size_t limit) {
+    uint64_t start = profiler_begin();
+    size_t total = 0;
+    bool open = true;
+    while (total < limit) {
+        ssize_t nread = read(term->pty_fd, term->read_buffer, sizeof(term->read_buffer));
+        if (nread < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            open = (errno == EAGAIN || errno == EWOULDBLOCK);
+            break;
         }
+        if (nread == 0) {
+            open = false;
+            break;
+        }
+
+        terminal_feed(term, (const uint8_t *)term->read_buffer, (size_t)nread);
+        total += (size_t)nread;
+    }
+
+    if (total > 0) {
+        terminal_publish(term);
+    }
+    if (term->input_len > 0 && !term->input_blocked) {
+        terminal_flush_input(term);  // Replies to queries in what was parsed
+    }
+    profiler_end(PROF_TERMINAL, start);
+    return open;
+}
+
+void terminal_update(Terminal *term) {
+    if (!term->active || term->pty_fd < 0) {
         return;
     }
 
-    if (nread == 0) {
+    // Check if shell has died
+    int status;
+    pid_t result = waitpid(term->shell_pid, &status, WNOHANG);
+    if (result != 0) {
+        // Shell has exited
+        terminal_close(term);
         return;
     }
 
-    // Parse each byte
-    for (ssize_t i = 0; i < nread; i++) {
-        terminal_parse_byte(term, (uint8_t)term->read_buffer[i]);
+    if (!terminal_drain(term, TERM_DRAIN_LIMIT)) {
+        // Error reading, close terminal
+        terminal_close(term);
     }
 }
@@ -2,22 +2,99 @@
 #define TERMINAL_H
 
 #include "types.h"
+#include "termcell.h"
+
+// The cell grid is a ring of rows so scrolling only rotates row_offset.
+// Logical row y lives in physical row (row_offset + y) % rows.
+static inline int terminal_physical_row(int row_offset, int rows, int y) {
+    int row = row_offset + y;
+    return row >= rows ? row - rows : row;
+}
+
+static inline TermCell *terminal_row(Terminal *term, int y) {
+    return term->cells + (size_t)terminal_physical_row(term->row_offset, term->rows, y) * term->cols;
+}
+
+static inline const TermCell *term_snapshot_phys_row(const TermSnapshot *snap, int phys) {
+    return snap->cells + (size_t)phys * snap->cols;
+}
+
+static inline const TermCell *term_snapshot_row(const TermSnapshot *snap, int y) {
+    return term_snapshot_phys_row(snap, terminal_physical_row(snap->row_offset, snap->rows, y));
+}
+
+// Colors of a published cell; indices the snapshot has not caught up with
+// fall back to the default attribute
+static inline const TermAttr *term_snapshot_attr(const TermSnapshot *snap, TermCell cell) {
+    int index = term_cell_attr(cell);
+    return &snap->attrs[index < snap->attr_count ? index : 0];
+}
 
 // Terminal initialization and lifecycle
 void terminal_init(Terminal *term);
 int terminal_spawn_shell(Terminal *term);
 void terminal_close(Terminal *term);
 
+// Close the terminal and free its grid, snapshot and history
+void terminal_destroy(Terminal *term);
+
+// Reallocate the grid (clamped to TERM_MAX_COLS x TERM_MAX_ROWS), keeping the
+// cursor row on screen; rows pushed off the top go to scrollback. A running
+// shell is told the new size with TIOCSWINSZ. Returns false if out of memory.
+bool terminal_resize(Terminal *term, int cols, int rows);
+
 // Terminal I/O
-void terminal_write(Terminal *term, const char *data, size_t len);
+// Queue bytes for the shell; nothing is written until terminal_flush_input.
+// The queue grows to TERM_INPUT_MAX bytes; returns false (queuing nothing)
+// if data doesn't fit, or the terminal isn't running.
+#define TERM_INPUT_MAX (4 * 1024 * 1024)
+bool terminal_write(Terminal *term, const char *data, size_t len);
+
+// terminal_paste results
+#define TERM_PASTE_OK 0
+#define TERM_PASTE_INACTIVE 1   // No running shell to paste into
+#define TERM_PASTE_TOO_LARGE 2  // Doesn't fit in the input queue
+
+// Queue clipboard text, bracketed when the application asked for it (DECSET
+// 2004). Newlines become carriage returns, as if typed. All or nothing, as
+// terminal_write.
+int terminal_paste(Terminal *term, const char *text);
+
+// Write as much queued input as the PTY takes. What's left is flushed when the
+// PTY becomes writable (see pty_io_watch_output) or on the next call.
+void terminal_flush_input(Terminal *term);
+
 void terminal_update(Terminal *term);
 
+// Upper bound on bytes parsed per terminal per drain so a flooding shell
+// cannot stall a frame; anything left is picked up on the next poll
+#define TERM_DRAIN_LIMIT (1024 * 1024)
+
+// Read and parse everything the PTY has buffered, up to limit bytes, then
+// publish. Returns false when the PTY hung up or failed and should close.
+bool terminal_drain(Terminal *term, size_t limit);
+
+// Copy changed rows, cursor and active state into term->published
+void terminal_publish(Terminal *term);
+
+// Move the view into scrollback history by lines (positive = further back),
+// clamped to what is stored; 0 lines back is the live screen
+void terminal_scroll_view(Terminal *term, int lines);
+
 // Terminal manipulation
 void terminal_clear(Terminal *term);
-void terminal_put_char(Terminal *term, char ch);
+// Write one codepoint at the cursor: double-width characters take two cells,
+// combining and zero-width ones are dropped
+void terminal_put_char(Terminal *term, uint32_t ch);
 void terminal_parse_byte(Terminal *term, uint8_t byte);
 
+// Parse a chunk of PTY output; runs of printable text bypass the
+// per-byte state machine and are written a row segment at a time
+void terminal_feed(Terminal *term, const uint8_t *data, size_t len);
+
 // Helper functions
+// Scroll the region between the DECSTBM margins (the whole screen by default)
+// up one line; a newline on the bottom margin does this
 void terminal_scroll_up(Terminal *term);
 void terminal_newline(Terminal *term);
 void terminal_carriage_return(Terminal *term);
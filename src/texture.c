@@ -13,6 +13,17 @@ uint32_t cabinet_textures[NUM_CABINET_TEXTURES][TEX_SIZE * TEX_SIZE];
 uint32_t sky_texture[SKY_TEXTURE_HEIGHT * SKY_TEXTURE_WIDTH];
 uint32_t display_texture[TEX_SIZE * TEX_SIZE];
 
+// Every level below the full-size one, for each texture of a set
+#define TEX_MIP_TEXELS ((TEX_SIZE * TEX_SIZE - 1) / 3)
+
+static uint32_t wall_mip_texels[NUM_WALL_TEXTURES * TEX_MIP_TEXELS];
+static uint32_t floor_mip_texels[NUM_FLOOR_TEXTURES * TEX_MIP_TEXELS];
+static uint32_t cabinet_mip_texels[NUM_CABINET_TEXTURES * TEX_MIP_TEXELS];
+
+MipChain wall_mips;
+MipChain floor_mips;
+MipChain cabinet_mips;
+
 void generate_wall_textures(void) {
     for (int t = 0; t < NUM_WALL_TEXTURES; ++t) {
         for (int y = 0; y < TEX_SIZE; ++y) {
@@ -263,3 +274,51 @@ void load_custom_textures(void) {
     snprintf(path, sizeof(path), "assets/textures/display.bmp");
     load_texture_from_bmp(path, display_texture);
 }
+
+// Rounded per-channel mean of four ARGB texels
+static uint32_t average_texels(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        uint32_t sum = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF) + ((c >> shift) & 0xFF) + ((d >> shift) & 0xFF);
+        result |= ((sum + 2) / 4) << shift;
+    }
+    return result;
+}
+
+static void build_mip_chain(MipChain *chain, const uint32_t *textures, int count, uint32_t *storage) {
+    chain->levels[0] = textures;
+    const uint32_t *src = textures;
+    for (int level = 1; level < TEX_MIP_LEVELS; ++level) {
+        int size = TEX_SIZE >> level;
+        int srcSize = size * 2;
+        for (int t = 0; t < count; ++t) {
+            const uint32_t *from = src + t * srcSize * srcSize;
+            uint32_t *to = storage + t * size * size;
+            for (int y = 0; y < size; ++y) {
+                const uint32_t *row0 = from + (y * 2) * srcSize;
+                const uint32_t *row1 = row0 + srcSize;
+                for (int x = 0; x < size; ++x) {
+                    to[y * size + x] = average_texels(row0[x * 2], row0[x * 2 + 1], row1[x * 2], row1[x * 2 + 1]);
+                }
+            }
+        }
+        chain->levels[level] = storage;
+        src = storage;
+        storage += count * size * size;
+    }
+}
+
+void build_texture_mips(void) {
+    build_mip_chain(&wall_mips, &wall_textures[0][0], NUM_WALL_TEXTURES, wall_mip_texels);
+    build_mip_chain(&floor_mips, &floor_textures[0][0], NUM_FLOOR_TEXTURES, floor_mip_texels);
+    build_mip_chain(&cabinet_mips, &cabinet_textures[0][0], NUM_CABINET_TEXTURES, cabinet_mip_texels);
+}
+
+int texture_mip_level(double texels_per_pixel) {
+    // Level n once a pixel spans 2^n texels, leaving 1 to 2 texels per pixel
+    int level = 0;
+    while (level < TEX_MIP_LEVELS - 1 && texels_per_pixel >= (double)(2 << level)) {
+        level++;
+    }
+    return level;
+}
@@ -14,6 +14,26 @@ extern uint32_t cabinet_textures[NUM_CABINET_TEXTURES][TEX_SIZE * TEX_SIZE];
 extern uint32_t sky_texture[SKY_TEXTURE_HEIGHT * SKY_TEXTURE_WIDTH];
 extern uint32_t display_texture[TEX_SIZE * TEX_SIZE];
 
+// Mip levels from TEX_SIZE x TEX_SIZE down to 1x1
+#define TEX_MIP_LEVELS 7
+
+// Mip chain of a texture set. levels[n] holds every texture of the set at
+// (TEX_SIZE >> n) texels square, one after another; levels[0] is the
+// full-size texture array itself.
+typedef struct {
+    const uint32_t *levels[TEX_MIP_LEVELS];
+} MipChain;
+
+extern MipChain wall_mips;
+extern MipChain floor_mips;
+extern MipChain cabinet_mips;
+
+// Texels of one texture at a mip level
+static inline const uint32_t *mip_texture(const MipChain *chain, int texture, int level) {
+    int size = TEX_SIZE >> level;
+    return chain->levels[level] + texture * size * size;
+}
+
 // Texture generation functions
 void generate_wall_textures(void);
 void generate_floor_textures(void);
@@ -26,4 +46,11 @@ void generate_display_texture(void);
 bool load_texture_from_bmp(const char *path, uint32_t *target);
 void load_custom_textures(void);
 
+// Box-filter the wall, floor and cabinet mip chains from the full-size
+// textures. Run once they are generated and loaded.
+void build_texture_mips(void);
+
+// Mip level for a surface drawn at texels_per_pixel texels per screen pixel
+int texture_mip_level(double texels_per_pixel);
+
 #endif // TEXTURE_H
@@ -19,12 +19,19 @@
 
 #define MAP_WIDTH 48
 #define MAP_HEIGHT 48
+// Layout size of the HUD, minimap and terminal mode; the window scales it
 #define SCREEN_WIDTH 960
 #define SCREEN_HEIGHT 600
+// The 3D view renders at its own runtime resolution within these bounds
+#define VIEW_MIN_WIDTH 160
+#define VIEW_MIN_HEIGHT 100
+#define VIEW_MAX_WIDTH 3840
+#define VIEW_MAX_HEIGHT 2400
 #define MAX_DEPTH 32.0
 #define MOVE_SPEED 3.7
 #define STRAFE_SPEED 3.0
 #define ROT_SPEED 2.4
+#define MAX_FRAME_STEP 0.1  // Seconds of movement simulated per frame at most, e.g. after idling
 #define FOV (M_PI / 3.0)
 
 #define TEX_SIZE 64
@@ -79,43 +86,147 @@ typedef struct {
     int spawn_y;
 } Map;
 
-// Terminal emulation structures
+// Terminal emulation structures. Grids are allocated per terminal and
+// resized at runtime (see terminal_resize); TERM_COLS x TERM_ROWS is the default.
 #define TERM_COLS 80
 #define TERM_ROWS 24
+#define TERM_MAX_COLS 256
+#define TERM_MAX_ROWS 128
+#define TERM_MAX_PARAM 65535 // Larger CSI parameters are capped while parsing
 
+// Terminal colors: 0-255 index the xterm palette (0-15 are the ANSI colors),
+// TERM_COLOR_RGB | 0xRRGGBB is a 24-bit color
+typedef uint32_t TermColor;
+#define TERM_COLOR_RGB 0x1000000u
+#define TERM_COLOR_DEFAULT_FG 7
+#define TERM_COLOR_DEFAULT_BG 0
+
+#define TERM_ATTR_BOLD 1
+#define TERM_ATTR_UNDERLINE 2
+#define TERM_ATTR_REVERSE 4
+
+// Colors and flags shared by a run of cells; each terminal interns the
+// combinations it uses (see termcell.h)
+typedef struct {
+    TermColor fg_color;
+    TermColor bg_color;
+    uint8_t attrs;       // TERM_ATTR_* flags
+    uint32_t fg_pixel;   // What to draw, resolved (reverse video included)
+    uint32_t bg_pixel;   // when the attribute is interned
+} TermAttr;
+
+// A cell packs a Unicode codepoint (low 21 bits) with an index into the
+// terminal's attribute table (high 11 bits), so a row fills with word stores
+typedef uint32_t TermCell;
+#define TERM_CELL_CHAR_BITS 21
+#define TERM_CELL_CHAR_MASK 0x1FFFFFu
+#define TERM_MAX_ATTRS (1 << (32 - TERM_CELL_CHAR_BITS))
+
+typedef struct {
+    TermAttr *entries;    // entries[0] is the default attribute
+    uint16_t *slots;      // Open-addressed hash: entry index + 1, 0 = empty
+    int count;
+    int capacity;         // Entries allocated; slots holds twice as many
+    uint32_t generation;  // Bumped whenever entries are renumbered
+} TermAttrTable;
+
+// Lines that scrolled off the top of a terminal (see scrollback.h)
 typedef struct {
-    char ch;
-    uint8_t fg_color;  // 0-15 (ANSI colors)
-    uint8_t bg_color;  // 0-15
-    uint8_t attrs;     // bold, underline, etc.
-} TermCell;
+    uint8_t **lines;  // Ring of encoded lines, allocated on the first push
+    int capacity;     // Maximum lines kept; 0 disables scrollback
+    int head;         // Index of the oldest line
+    int count;
+} Scrollback;
+
+// Copy of a terminal's visible state, published for the renderer so the
+// I/O thread can keep parsing while a frame is drawn
+typedef struct {
+    TermCell *cells;          // rows x cols in physical row order, see Terminal.row_offset
+    uint32_t *row_versions;
+    TermAttr *attrs;          // Copy of the terminal's attribute table
+    int attr_count;
+    int attr_capacity;
+    uint32_t attr_generation;
+    int cols;
+    int rows;
+    int row_offset;
+    uint32_t content_version;
+    int cursor_x;
+    int cursor_y;
+    bool cursor_visible;
+    bool active;
+    int view_offset;    // Lines scrolled back into history (0 = live)
+    int history_lines;
+    uint32_t publish_count; // Bumped by every publish; the main loop redraws when it moves
+} TermSnapshot;
 
 typedef enum {
     PARSE_NORMAL,
     PARSE_ESC,
     PARSE_CSI,
-    PARSE_CSI_PARAM
+    PARSE_CSI_PARAM,
+    PARSE_UTF8,
+    PARSE_ESC_G0,       // ESC ( x: x names the G0 charset
+    PARSE_ESC_ARG,      // ESC ) x, ESC # x and friends: x is ignored
+    PARSE_STRING,       // OSC, DCS, APC, PM: ignored up to BEL or ST (ESC backslash)
+    PARSE_STRING_ESC
 } ParseState;
 
+// Grids, snapshot and history live on the heap: zero a Terminal before its
+// first terminal_init, which frees them on every later call
 typedef struct {
-    TermCell cells[TERM_ROWS][TERM_COLS];
+    TermCell *cells;     // rows x cols ring of rows; use terminal_row() for logical rows
+    int cols;
+    int rows;
+    int row_offset;      // Physical row holding logical row 0
     int cursor_x;
     int cursor_y;
     bool cursor_visible;
-    int saved_cursor_x;  // For CSI s/u (save/restore cursor)
+    bool wrap_pending;   // Last column written: the next character wraps first
+    bool autowrap;       // DECAWM
+    bool insert_mode;    // IRM: characters push the rest of the line right
+    bool app_cursor_keys; // DECCKM: arrow keys send ESC O x
+    bool charset_graphics; // G0 is DEC special graphics (ESC ( 0)
+    int scroll_top;      // DECSTBM margins, inclusive logical rows
+    int scroll_bottom;
+    bool alt_screen;     // The alternate screen (DECSET 47/1047/1049) is shown
+    TermCell *inactive_cells; // The screen not shown: alternate one allocated on first use
+    int inactive_row_offset;
+    int saved_cursor_x;  // For DECSC/DECRC and CSI s/u (save/restore cursor)
     int saved_cursor_y;
+    TermColor saved_fg;
+    TermColor saved_bg;
+    uint8_t saved_attrs;
+    bool saved_charset_graphics;
     int pty_fd;          // PTY file descriptor
     pid_t shell_pid;     // Shell process ID
     bool active;
     char read_buffer[4096];
+    char *input_buffer;  // Ring of keystrokes and replies queued for the shell
+    size_t input_capacity;
+    size_t input_head;   // Oldest queued byte
+    size_t input_len;
+    bool input_blocked;  // PTY was full: the reactor waits for it to drain
+    bool bracketed_paste; // DECSET 2004: pastes arrive between ESC[200~ and ESC[201~
     ParseState parse_state;     // For ANSI parser state machine
+    uint32_t utf8_codepoint;    // Multi-byte sequence being decoded (PARSE_UTF8)
+    uint32_t utf8_min;          // Smallest codepoint its length may encode
+    int utf8_remaining;         // Continuation bytes still expected
     int ansi_params[16]; // Parameters from escape sequences
     int ansi_param_count;
-    uint8_t current_fg;  // Current foreground color
-    uint8_t current_bg;  // Current background color
+    TermColor current_fg; // Current foreground color
+    TermColor current_bg; // Current background color
     uint8_t current_attrs; // Current attributes
+    uint16_t current_attr; // Interned index of current_fg/bg/attrs
+    TermAttrTable attr_table;
+    int attr_compact_backoff; // Table-full SGRs to take before compacting again
     char csi_buffer[64]; // Buffer for CSI sequence
     int csi_buffer_len;
+    uint32_t *row_versions;           // Per physical row, bumped whenever its cells change
+    uint32_t content_version;         // Latest row version, for "anything changed?" checks
+    TermSnapshot published;           // Renderer-side copy, see terminal_publish()
+    Scrollback history;               // Lines that scrolled off the top
+    int view_offset;                  // Lines scrolled back into history (0 = live)
 } Terminal;
 
 typedef enum {
@@ -178,6 +289,7 @@ typedef struct {
     bool terminal_mode;
     int active_terminal;  // Which terminal is currently being viewed
     int skip_display_frames;  // Skip display rendering for N frames after exit
+    uint32_t world_version;   // Bumped when doors, cabinets or displays change; see render_scene
     HudStatus hud_status;
     double hud_bob_phase;
     double hud_bob_offset;
@@ -2,6 +2,7 @@
 #include "ui.h"
 #include "utils.h"
 #include "map.h"
+#include "profiler.h"
 #include "../include/font8x8_basic.h"
 #include <string.h>
 #include <stdio.h>
@@ -643,11 +644,12 @@ void render_rename_dialog(uint32_t *pixels, const Game *game) {
         return;
     }
 
-    // Draw semi-transparent background overlay
+    // Draw semi-transparent background overlay. Where the HUD layer is clear
+    // the view shows through, so darken it with half-transparent black.
     for (int y = 0; y < SCREEN_HEIGHT; ++y) {
         for (int x = 0; x < SCREEN_WIDTH; ++x) {
             uint32_t current = pixels[y * SCREEN_WIDTH + x];
-            uint32_t darkened = blend_colors(current, pack_color(0, 0, 0), 0.5);
+            uint32_t darkened = (current >> 24) ? blend_colors(current, pack_color(0, 0, 0), 0.5) : 0x80000000u;
             pixels[y * SCREEN_WIDTH + x] = darkened;
         }
     }
@@ -705,3 +707,24 @@ void render_rename_dialog(uint32_t *pixels, const Game *game) {
     draw_text(pixels, boxX + 20, boxY + 120, "Use LEFT/RIGHT arrows to change color", pack_color(150, 150, 150));
     draw_text(pixels, boxX + 20, boxY + 140, "Press ENTER to confirm, ESC to cancel", pack_color(150, 150, 150));
 }
+
+void render_profiler_panel(uint32_t *pixels) {
+    draw_rect(pixels, 0, 0, PROFILER_PANEL_WIDTH, PROFILER_PANEL_HEIGHT, pack_color(6, 10, 16));
+    draw_frame(pixels, 0, 0, PROFILER_PANEL_WIDTH, PROFILER_PANEL_HEIGHT, pack_color(20, 30, 45));
+    draw_text(pixels, 8, 8, "ms           avg    p99", pack_color(160, 200, 255));
+
+    char line[48];
+    int y = 22;
+    for (int i = 0; i < PROF_SECTION_COUNT; i++, y += 12) {
+        ProfStat stat;
+        if (profiler_stat((ProfSection)i, &stat)) {
+            snprintf(line, sizeof(line), "%-9s %6.2f %6.2f", profiler_section_name((ProfSection)i), stat.avg_ms,
+                     stat.p99_ms);
+        } else {
+            snprintf(line, sizeof(line), "%-9s      -      -", profiler_section_name((ProfSection)i));
+        }
+        draw_text(pixels, 8, y, line, i == PROF_FRAME ? pack_color(255, 255, 255) : pack_color(180, 180, 180));
+    }
+    draw_text(pixels, 8, y + 4, profiler_tracing() ? "F3: stop trace (recording)" : "F3: record trace",
+              profiler_tracing() ? pack_color(255, 120, 120) : pack_color(120, 140, 160));
+}
@@ -18,6 +18,12 @@ int layout_text_lines(const char *text, int chars_per_line, char lines[][MAX_LAY
 void render_minimap(uint32_t *pixels, const Game *game);
 void render_hud(uint32_t *pixels, const Game *game);
 void render_rename_dialog(uint32_t *pixels, const Game *game);
+
+// Profiler statistics panel, drawn at the top left of a buffer with the
+// framebuffer's row stride
+#define PROFILER_PANEL_WIDTH 224
+#define PROFILER_PANEL_HEIGHT 148
+void render_profiler_panel(uint32_t *pixels);
 uint32_t get_cabinet_color_by_index(int index);
 const char* get_cabinet_color_name_by_index(int index);
 
@@ -0,0 +1,139 @@
+// DDA benchmark - compares the double and 16.16 fixed-point raycasting backends
+#define _POSIX_C_SOURCE 200809L
+#include "types.h"
+#include "map.h"
+#include "raycast.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_ANGLES 720
+#define BENCH_POSITIONS 16
+
+typedef struct {
+    double posX;
+    double posY;
+} BenchOrigin;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool blocks_ray(const Map *map, int x, int y) {
+    if (x < 0 || y < 0 || x >= map->width || y >= map->height) {
+        return true;
+    }
+    char tile = map->tiles[y][x];
+    return tile == 'D' || tile_is_wall(tile);
+}
+
+static double cast_double(const Map *map, double posX, double posY, double rayDirX, double rayDirY) {
+    DdaDouble dda;
+    dda_double_begin(&dda, posX, posY, rayDirX, rayDirY, dda_delta_dist(rayDirX), dda_delta_dist(rayDirY));
+    do {
+        dda_double_step(&dda);
+    } while (!blocks_ray(map, dda.mapX, dda.mapY));
+    return dda_double_distance(&dda) + dda_double_wall_x(&dda) * 1e-9;
+}
+
+static double cast_fixed(const Map *map, double posX, double posY, double rayDirX, double rayDirY) {
+    DdaFixed dda;
+    dda_fixed_begin(&dda, posX, posY, rayDirX, rayDirY, dda_delta_dist(rayDirX), dda_delta_dist(rayDirY));
+    do {
+        dda_fixed_step(&dda);
+    } while (!blocks_ray(map, dda.mapX, dda.mapY));
+    return dda_fixed_distance(&dda) + dda_fixed_wall_x(&dda) * 1e-9;
+}
+
+static int pick_origins(const Map *map, BenchOrigin *origins, int max_origins) {
+    int count = 0;
+    for (int y = 1; y < map->height - 1 && count < max_origins; y += 3) {
+        for (int x = 1; x < map->width - 1 && count < max_origins; x += 5) {
+            if (!blocks_ray(map, x, y)) {
+                origins[count].posX = x + 0.37;
+                origins[count].posY = y + 0.61;
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : MAP_FILE_DEFAULT;
+    int passes = argc > 2 ? atoi(argv[2]) : 200;
+    if (passes < 1) {
+        passes = 1;
+    }
+
+    Map map = {0};
+    if (!load_map_from_file(path, &map)) {
+        fprintf(stderr, "raybench: failed to load %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    BenchOrigin origins[BENCH_POSITIONS];
+    int origin_count = pick_origins(&map, origins, BENCH_POSITIONS);
+    if (origin_count == 0) {
+        fprintf(stderr, "raybench: no open tiles in %s\n", path);
+        map_free(&map);
+        return EXIT_FAILURE;
+    }
+
+    double dirX[BENCH_ANGLES];
+    double dirY[BENCH_ANGLES];
+    for (int i = 0; i < BENCH_ANGLES; ++i) {
+        double angle = i * (2.0 * M_PI / BENCH_ANGLES);
+        dirX[i] = cos(angle);
+        dirY[i] = sin(angle);
+    }
+
+    // Accuracy: worst distance deviation of the fixed backend from the double one
+    double max_error = 0.0;
+    for (int o = 0; o < origin_count; ++o) {
+        for (int i = 0; i < BENCH_ANGLES; ++i) {
+            double ref = cast_double(&map, origins[o].posX, origins[o].posY, dirX[i], dirY[i]);
+            double fix = cast_fixed(&map, origins[o].posX, origins[o].posY, dirX[i], dirY[i]);
+            if (fabs(ref - fix) > max_error) {
+                max_error = fabs(ref - fix);
+            }
+        }
+    }
+
+    long rays = (long)passes * origin_count * BENCH_ANGLES;
+    volatile double sink = 0.0;
+
+    double start = now_seconds();
+    for (int p = 0; p < passes; ++p) {
+        for (int o = 0; o < origin_count; ++o) {
+            for (int i = 0; i < BENCH_ANGLES; ++i) {
+                sink += cast_double(&map, origins[o].posX, origins[o].posY, dirX[i], dirY[i]);
+            }
+        }
+    }
+    double double_time = now_seconds() - start;
+
+    start = now_seconds();
+    for (int p = 0; p < passes; ++p) {
+        for (int o = 0; o < origin_count; ++o) {
+            for (int i = 0; i < BENCH_ANGLES; ++i) {
+                sink += cast_fixed(&map, origins[o].posX, origins[o].posY, dirX[i], dirY[i]);
+            }
+        }
+    }
+    double fixed_time = now_seconds() - start;
+    (void)sink;
+
+    printf("map: %s (%dx%d), %d origins x %d angles x %d passes = %ld rays\n", path, map.width, map.height,
+           origin_count, BENCH_ANGLES, passes, rays);
+    printf("double: %8.2f Mrays/s\n", rays / double_time / 1e6);
+    printf("fixed:  %8.2f Mrays/s (%.2fx)\n", rays / fixed_time / 1e6, double_time / fixed_time);
+    printf("max distance error: %.6f tiles\n", max_error);
+    printf("build backend: %s\n", TSS_FIXED_DDA ? "fixed 16.16" : "double");
+
+    map_free(&map);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+// Render benchmark - draws a scripted walk through palace.map into an offscreen
+// framebuffer, no window needed, and reports frame rate, per-pass timings and
+// a checksum of every frame so pixel changes are caught along with slowdowns
+#define _POSIX_C_SOURCE 200809L
+#include "types.h"
+#include "game.h"
+#include "map.h"
+#include "renderer.h"
+#include "resolution.h"
+#include "texture.h"
+#include "profiler.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MAP "maps/palace.map"
+#define BENCH_FRAMES 600
+#define BENCH_WARMUP 30
+#define BENCH_SPEED 0.1         // Tiles per frame: one lap of the path in about 510 frames
+#define BENCH_LOOK_SWAY 0.6     // Radians either side of the walking direction
+
+typedef struct {
+    double x;
+    double y;
+} BenchPoint;
+
+// A loop through both halves of the station, past the cabinets and the
+// doors, down into the small room and back
+static const BenchPoint bench_path[] = {
+    {4.5, 2.5}, {20.5, 2.5}, {20.5, 8.5}, {11.5, 8.5}, {11.5, 4.5},
+    {5.5, 4.5}, {5.5, 8.5}, {5.5, 4.5},
+};
+#define BENCH_PATH_POINTS ((int)(sizeof(bench_path) / sizeof(bench_path[0])))
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double segment_length(int i) {
+    const BenchPoint *a = &bench_path[i];
+    const BenchPoint *b = &bench_path[(i + 1) % BENCH_PATH_POINTS];
+    return hypot(b->x - a->x, b->y - a->y);
+}
+
+// Every segment must run through open floor, or the camera walks through walls
+static bool path_fits_map(const Map *map) {
+    for (int i = 0; i < BENCH_PATH_POINTS; i++) {
+        const BenchPoint *a = &bench_path[i];
+        const BenchPoint *b = &bench_path[(i + 1) % BENCH_PATH_POINTS];
+        int steps = (int)(segment_length(i) * 8) + 1;
+        for (int s = 0; s <= steps; s++) {
+            double t = (double)s / steps;
+            int x = (int)(a->x + (b->x - a->x) * t);
+            int y = (int)(a->y + (b->y - a->y) * t);
+            if (x < 0 || y < 0 || x >= map->width || y >= map->height) {
+                return false;
+            }
+            char tile = map->tiles[y][x];
+            if (tile_is_wall(tile) || tile == 'D' || tile == 'd' || tile == 'C') {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Camera pose for a frame: constant speed along the loop, looking along the
+// current segment with a slow sway so the walls to either side are drawn too
+static void place_camera(Game *game, int frame) {
+    double loop = 0.0;
+    for (int i = 0; i < BENCH_PATH_POINTS; i++) {
+        loop += segment_length(i);
+    }
+    double distance = fmod(frame * BENCH_SPEED, loop);
+    int segment = 0;
+    while (distance > segment_length(segment)) {
+        distance -= segment_length(segment);
+        segment++;
+    }
+    const BenchPoint *a = &bench_path[segment];
+    const BenchPoint *b = &bench_path[(segment + 1) % BENCH_PATH_POINTS];
+    double t = distance / segment_length(segment);
+    game->player.x = a->x + (b->x - a->x) * t;
+    game->player.y = a->y + (b->y - a->y) * t;
+    game->player.angle = atan2(b->y - a->y, b->x - a->x) + sin(frame * 0.03) * BENCH_LOOK_SWAY;
+    game_update_hud_bob(game, true, 1.0 / 60.0);
+}
+
+// FNV-1a over the view and HUD layers, chained from frame to frame
+static uint64_t hash_pixels(uint64_t hash, const uint32_t *pixels, size_t count) {
+    const uint8_t *bytes = (const uint8_t *)pixels;
+    for (size_t i = 0; i < count * sizeof(uint32_t); i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static int compare_floats(const void *a, const void *b) {
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static void usage(const char *program) {
+    fprintf(stderr, "usage: %s [frames [expected checksum]]\n", program);
+    fprintf(stderr, "  frames defaults to %d; with a checksum from an earlier run, exits 1 if the pixels differ\n",
+            BENCH_FRAMES);
+}
+
+int main(int argc, char **argv) {
+    int frames = BENCH_FRAMES;
+    if (argc > 1) {
+        char *end;
+        errno = 0;
+        long requested = strtol(argv[1], &end, 10);
+        if (end == argv[1] || *end != '\0' || errno != 0 || requested < 1 || requested > 1000000) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        frames = (int)requested;
+    }
+    if (argc > 3) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char *expected = argc > 2 ? argv[2] : NULL;
+
+    // Fixed seed and map so every run draws the same frames
+    srand(1234);
+    setenv("TSS_MAP_FILE", BENCH_MAP, 1);
+    generate_wall_textures();
+    generate_floor_textures();
+    generate_ceiling_textures();
+    generate_cabinet_texture();
+    generate_sky_texture();
+    generate_display_texture();
+    load_custom_textures();
+    build_texture_mips();
+
+    Game game;
+    game_init(&game);
+    if (!game.map.tiles || !path_fits_map(&game.map)) {
+        fprintf(stderr, "renderbench: %s missing or its layout doesn't fit the camera path\n", BENCH_MAP);
+        return EXIT_FAILURE;
+    }
+
+    // The view at the window's own size scaled by TSS_RENDER_SCALE, as in the game
+    double scale = resolution_default_scale();
+    if (!renderer_set_view_size((int)(SCREEN_WIDTH * scale + 0.5), (int)(SCREEN_HEIGHT * scale + 0.5))) {
+        fprintf(stderr, "renderbench: out of memory\n");
+        return EXIT_FAILURE;
+    }
+    int view_width;
+    int view_height;
+    const uint32_t *view = renderer_view(&view_width, &view_height);
+
+    uint32_t *hud = calloc(SCREEN_WIDTH * SCREEN_HEIGHT, sizeof(uint32_t));
+    float *samples = malloc(sizeof(float) * (size_t)frames * PROF_SECTION_COUNT);
+    float *sorted = malloc(sizeof(float) * (size_t)frames);
+    if (!hud || !samples || !sorted) {
+        fprintf(stderr, "renderbench: out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    // Start the render workers and fault in the caches before timing
+    for (int i = 0; i < BENCH_WARMUP; i++) {
+        place_camera(&game, frames + i);
+        render_scene(&game, hud);
+    }
+
+    // The overlay switch is what turns the pass timers on
+    profiler_set_overlay(true);
+    uint64_t checksum = 14695981039346656037ull;
+    double total = 0.0;
+    for (int i = 0; i < frames; i++) {
+        place_camera(&game, i);
+        double start = now_seconds();
+        uint64_t frame_start = profiler_begin();
+        render_scene(&game, hud);
+        profiler_end(PROF_FRAME, frame_start);
+        total += now_seconds() - start;
+
+        profiler_frame_end();
+        for (int s = 0; s < PROF_SECTION_COUNT; s++) {
+            ProfStat stat;
+            samples[(size_t)s * frames + i] = profiler_stat(s, &stat) ? (float)stat.last_ms : 0.0f;
+        }
+        checksum = hash_pixels(checksum, view, (size_t)view_width * view_height);
+        checksum = hash_pixels(checksum, hud, SCREEN_WIDTH * SCREEN_HEIGHT);
+    }
+    profiler_set_overlay(false);
+
+    printf("map: %s, %d frames, view %dx%d, HUD %dx%d, %d warm-up\n", BENCH_MAP, frames, view_width, view_height,
+           SCREEN_WIDTH, SCREEN_HEIGHT, BENCH_WARMUP);
+    printf("%.1f frames/s (%.3f ms/frame)\n", frames / total, total * 1000.0 / frames);
+    printf("%-10s %10s %10s\n", "pass", "avg ms", "p99 ms");
+    for (int s = 0; s < PROF_SECTION_COUNT; s++) {
+        if (s == PROF_TERMINAL || s == PROF_UPLOAD) {
+            continue;  // Main-loop passes, not part of render_scene
+        }
+        double sum = 0.0;
+        for (int i = 0; i < frames; i++) {
+            sorted[i] = samples[(size_t)s * frames + i];
+            sum += sorted[i];
+        }
+        qsort(sorted, (size_t)frames, sizeof(float), compare_floats);
+        printf("%-10s %10.3f %10.3f\n", profiler_section_name(s), sum / frames,
+               sorted[(frames * 99 + 99) / 100 - 1]);
+    }
+    printf("checksum: %016" PRIx64 "\n", checksum);
+
+    int status = EXIT_SUCCESS;
+    if (expected) {
+        char actual[17];
+        snprintf(actual, sizeof(actual), "%016" PRIx64, checksum);
+        if (strcmp(actual, expected) != 0) {
+            fprintf(stderr, "renderbench: checksum mismatch, expected %s\n", expected);
+            status = EXIT_FAILURE;
+        } else {
+            printf("checksum matches\n");
+        }
+    }
+
+    renderer_shutdown();
+    free(sorted);
+    free(samples);
+    free(hud);
+    game_cleanup_terminals(&game);
+    game_free_game_maps(&game);
+    map_free(&game.map);
+    return status;
+}
@@ -0,0 +1,315 @@
+// Terminal parser benchmark - bulk terminal_feed vs the per-byte state machine,
+// on synthetic streams and on PTY output captured from real programs
+#define _POSIX_C_SOURCE 200809L
+#include "types.h"
+#include "terminal.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_STREAM_BYTES (8 * 1024 * 1024)
+#define BENCH_CHUNK 4096
+
+typedef struct {
+    char name[32];
+    uint8_t *data;
+    size_t len;
+} BenchStream;
+
+static Terminal bench_term;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static size_t append(uint8_t *dst, size_t len, const char *text) {
+    size_t n = strlen(text);
+    if (len + n > BENCH_STREAM_BYTES) {
+        return len;
+    }
+    memcpy(dst + len, text, n);
+    return len + n;
+}
+
+static void random_word(char *out, int max_len) {
+    int n = 2 + rand() % (max_len - 2);
+    for (int i = 0; i < n; i++) {
+        out[i] = (char)('a' + rand() % 26);
+    }
+    out[n] = '\0';
+}
+
+// `ls -R` / `cat` style output: plain lines of words
+static size_t build_plain(uint8_t *dst) {
+    size_t len = 0;
+    char word[16];
+    while (len + 128 < BENCH_STREAM_BYTES) {
+        int words = 1 + rand() % 10;
+        for (int w = 0; w < words; w++) {
+            random_word(word, 12);
+            len = append(dst, len, word);
+            len = append(dst, len, w + 1 < words ? " " : "\r\n");
+        }
+    }
+    return len;
+}
+
+// Colourised output (`ls --color`, compiler diagnostics): SGR around words
+static size_t build_sgr(uint8_t *dst) {
+    size_t len = 0;
+    char word[16];
+    char sgr[16];
+    while (len + 128 < BENCH_STREAM_BYTES) {
+        int words = 1 + rand() % 8;
+        for (int w = 0; w < words; w++) {
+            snprintf(sgr, sizeof(sgr), "\033[%d;%dm", rand() % 2, 30 + rand() % 8);
+            len = append(dst, len, sgr);
+            random_word(word, 12);
+            len = append(dst, len, word);
+            len = append(dst, len, "\033[0m");
+            len = append(dst, len, w + 1 < words ? " " : "\r\n");
+        }
+    }
+    return len;
+}
+
+// Full-screen redraws (`top`, `htop`): cursor moves, short fields, erase-line
+static size_t build_screen(uint8_t *dst) {
+    size_t len = 0;
+    char cmd[32];
+    char word[16];
+    while (len + 128 < BENCH_STREAM_BYTES) {
+        snprintf(cmd, sizeof(cmd), "\033[%d;%dH", 1 + rand() % TERM_ROWS, 1 + rand() % 60);
+        len = append(dst, len, cmd);
+        random_word(word, 10);
+        len = append(dst, len, word);
+        len = append(dst, len, "\033[K");
+    }
+    return len;
+}
+
+// Non-ASCII text (`tree`, `htop` meters, localized output): box drawing,
+// block elements and accented words between plain ones
+static size_t build_utf8(uint8_t *dst) {
+    static const char *pieces[] = {"\u251c\u2500\u2500 ", "\u2502   ", "\u2514\u2500\u2500 ",
+                                   "\u2588\u2588\u2588\u258c", "caf\u00e9 ", "na\u00efve ",
+                                   "\u00fcber ", "\u4e2d\u6587 "};
+    size_t len = 0;
+    char word[16];
+    while (len + 128 < BENCH_STREAM_BYTES) {
+        int words = 1 + rand() % 8;
+        for (int w = 0; w < words; w++) {
+            len = append(dst, len, pieces[rand() % (int)(sizeof(pieces) / sizeof(pieces[0]))]);
+            random_word(word, 10);
+            len = append(dst, len, word);
+            len = append(dst, len, w + 1 < words ? " " : "\r\n");
+        }
+    }
+    return len;
+}
+
+// Pager / editor scrolling (`less`, vim): lines scroll inside a region that
+// stops above a status line, with the odd reverse scroll back up
+static size_t build_region(uint8_t *dst) {
+    size_t len = 0;
+    char cmd[32];
+    char word[16];
+    snprintf(cmd, sizeof(cmd), "\033[1;%dr\033[%dH", TERM_ROWS - 1, TERM_ROWS - 1);
+    len = append(dst, len, cmd);
+    while (len + 128 < BENCH_STREAM_BYTES) {
+        if (rand() % 8 == 0) {
+            len = append(dst, len, "\033[H\033M");
+            snprintf(cmd, sizeof(cmd), "\033[%dH", TERM_ROWS - 1);
+        } else {
+            len = append(dst, len, "\r\n");
+            snprintf(cmd, sizeof(cmd), "\033[%dH:", TERM_ROWS);
+        }
+        random_word(word, 14);
+        len = append(dst, len, word);
+        len = append(dst, len, cmd);
+        snprintf(cmd, sizeof(cmd), "\033[%dH", TERM_ROWS - 1);
+        len = append(dst, len, cmd);
+    }
+    return len;
+}
+
+// Truecolor images (chafa, lolcat): every cell gets its own foreground and
+// background, more combinations than the attribute table can hold
+static size_t build_truecolor(uint8_t *dst) {
+    size_t len = 0;
+    char cell[48];
+    int cells = 0;
+    while (len + 128 < BENCH_STREAM_BYTES) {
+        if (cells++ % (TERM_COLS * TERM_ROWS - 1) == 0) {
+            len = append(dst, len, "\033[H");
+        }
+        snprintf(cell, sizeof(cell), "\033[38;2;%d;%d;%d;48;2;%d;%d;%dm\u2580", rand() % 256, rand() % 256,
+                 rand() % 256, rand() % 256, rand() % 256, rand() % 256);
+        len = append(dst, len, cell);
+    }
+    return len;
+}
+
+static double run_stream(const BenchStream *stream, int passes, bool bulk) {
+    terminal_init(&bench_term);
+    double start = now_seconds();
+    for (int p = 0; p < passes; p++) {
+        for (size_t off = 0; off < stream->len; off += BENCH_CHUNK) {
+            size_t n = stream->len - off < BENCH_CHUNK ? stream->len - off : BENCH_CHUNK;
+            if (bulk) {
+                terminal_feed(&bench_term, stream->data + off, n);
+            } else {
+                for (size_t i = 0; i < n; i++) {
+                    terminal_parse_byte(&bench_term, stream->data[off + i]);
+                }
+            }
+        }
+    }
+    double elapsed = now_seconds() - start;
+    return (double)stream->len * passes / elapsed / (1024.0 * 1024.0);
+}
+
+// Cells whose contents differ after each chunk, the way a PTY read would
+// leave them for the renderer: the work the parser's output causes downstream
+static double count_changed_cells(const BenchStream *stream, int passes) {
+    terminal_init(&bench_term);
+    int cols = bench_term.cols;
+    int rows = bench_term.rows;
+    TermCell *shadow = malloc(sizeof(TermCell) * (size_t)cols * rows);
+    if (!shadow) {
+        return 0.0;
+    }
+    for (int y = 0; y < rows; y++) {
+        memcpy(shadow + (size_t)y * cols, terminal_row(&bench_term, y), sizeof(TermCell) * cols);
+    }
+
+    double changed = 0.0;
+    for (int p = 0; p < passes; p++) {
+        for (size_t off = 0; off < stream->len; off += BENCH_CHUNK) {
+            size_t n = stream->len - off < BENCH_CHUNK ? stream->len - off : BENCH_CHUNK;
+            terminal_feed(&bench_term, stream->data + off, n);
+            for (int y = 0; y < rows; y++) {
+                const TermCell *row = terminal_row(&bench_term, y);
+                TermCell *old = shadow + (size_t)y * cols;
+                for (int x = 0; x < cols; x++) {
+                    if (row[x] != old[x]) {
+                        old[x] = row[x];
+                        changed++;
+                    }
+                }
+            }
+        }
+    }
+    free(shadow);
+    return changed;
+}
+
+// A capture is replayed byte for byte as recorded with `script`
+static bool load_capture(BenchStream *stream, const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    stream->data = size > 0 ? malloc((size_t)size) : NULL;
+    stream->len = stream->data ? fread(stream->data, 1, (size_t)size, file) : 0;
+    fclose(file);
+    if (stream->len == 0) {
+        fprintf(stderr, "termbench: %s is empty or unreadable\n", path);
+        free(stream->data);
+        return false;
+    }
+
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    snprintf(stream->name, sizeof(stream->name), "%.*s", (int)strcspn(base, "."), base);
+    return true;
+}
+
+static void run_captures(char **paths, int count, int passes) {
+    printf("\ncaptured streams, each replayed to %d MB per pass\n", BENCH_STREAM_BYTES / (1024 * 1024));
+    printf("%-12s %8s %12s %12s %14s\n", "stream", "size", "per-byte", "bulk", "cells changed");
+    for (int i = 0; i < count; i++) {
+        BenchStream capture;
+        if (!load_capture(&capture, paths[i])) {
+            continue;
+        }
+        // Short captures are looped so every stream is timed over the same volume
+        int repeats = passes * (capture.len < BENCH_STREAM_BYTES ? (int)(BENCH_STREAM_BYTES / capture.len) : 1);
+        double per_byte = run_stream(&capture, repeats, false);
+        double bulk = run_stream(&capture, repeats, true);
+        double seconds = (double)capture.len * repeats / (bulk * 1024.0 * 1024.0);
+        double cells = count_changed_cells(&capture, repeats);
+        printf("%-12s %5zu KB %7.1f MB/s %7.1f MB/s %8.1f M/s\n", capture.name, capture.len / 1024, per_byte,
+               bulk, cells / seconds / 1e6);
+        free(capture.data);
+    }
+}
+
+// termbench [passes] [capture files...]
+static void usage(const char *program) {
+    fprintf(stderr, "usage: %s [passes [capture.pty...]]\n", program);
+    fprintf(stderr, "  passes defaults to 4; captures are replayed after the synthetic streams\n");
+}
+
+int main(int argc, char **argv) {
+    int passes = 4;
+    if (argc > 1) {
+        char *end;
+        errno = 0;
+        long requested = strtol(argv[1], &end, 10);
+        if (end == argv[1] || *end != '\0' || errno != 0 || requested < 1 || requested > 1000) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        passes = (int)requested;
+    }
+
+    srand(1234);
+    BenchStream streams[] = {
+        {"plain", NULL, 0},
+        {"sgr", NULL, 0},
+        {"screen", NULL, 0},
+        {"utf8", NULL, 0},
+        {"region", NULL, 0},
+        {"truecolor", NULL, 0},
+    };
+    size_t (*builders[])(uint8_t *) = {build_plain, build_sgr, build_screen, build_utf8, build_region,
+                                       build_truecolor};
+    int stream_count = (int)(sizeof(streams) / sizeof(streams[0]));
+
+    for (int i = 0; i < stream_count; i++) {
+        streams[i].data = malloc(BENCH_STREAM_BYTES);
+        if (!streams[i].data) {
+            fprintf(stderr, "termbench: out of memory\n");
+            return EXIT_FAILURE;
+        }
+        streams[i].len = builders[i](streams[i].data);
+    }
+
+    printf("%d passes over %d MB streams, %d byte chunks\n", passes,
+           BENCH_STREAM_BYTES / (1024 * 1024), BENCH_CHUNK);
+    printf("%-9s %12s %12s %8s\n", "stream", "per-byte", "bulk", "speedup");
+    for (int i = 0; i < stream_count; i++) {
+        double per_byte = run_stream(&streams[i], passes, false);
+        double bulk = run_stream(&streams[i], passes, true);
+        printf("%-9s %7.1f MB/s %7.1f MB/s %7.2fx\n", streams[i].name, per_byte, bulk, bulk / per_byte);
+    }
+
+    for (int i = 0; i < stream_count; i++) {
+        free(streams[i].data);
+    }
+
+    if (argc > 2) {
+        run_captures(argv + 2, argc - 2, passes);
+    }
+    terminal_destroy(&bench_term);
+    return EXIT_SUCCESS;
+}
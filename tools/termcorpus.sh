@@ -0,0 +1,124 @@
+#!/bin/sh
+# Regenerate the PTY captures in tools/corpus/terminal. Every program runs at
+# 80x24 under script(1), in a scratch directory holding only files made here,
+# so the captures contain nothing from the machine that recorded them.
+# Needs util-linux script, procps-ng top, vim and git.
+set -e
+
+repo=$(cd "$(dirname "$0")/.." && pwd)
+out="$repo/tools/corpus/terminal"
+work=$(mktemp -d)
+sleepers=
+trap 'kill $sleepers 2>/dev/null; rm -rf "$work"' EXIT
+cd "$work"
+
+export HOME="$work/home" TERM=xterm-256color LANG=C.UTF-8 TZ=UTC
+mkdir -p "$HOME/.config/procps" raw
+
+# Record one command, dropping the header and trailer lines script adds
+capture() {
+    script -q -e -O "$work/raw/$1" -c "stty cols 80 rows 24; $2" </dev/null >/dev/null
+    LC_ALL=C sed '1d;$d' "$work/raw/$1" >"$out/$1.pty"
+}
+
+# ls -laR --color over a fixed tree: directories, sources, archives,
+# executables and symlinks, all with the same timestamp
+for d in $(seq -w 1 40); do
+    mkdir -p "tree/module$d/include" "tree/module$d/assets"
+    for f in $(seq -w 1 12); do
+        printf 'int unit%s_%s;\n' "$d" "$f" >"tree/module$d/unit$f.c"
+        printf '#pragma once\n' >"tree/module$d/include/unit$f.h"
+    done
+    : >"tree/module$d/assets/sprite.png"
+    : >"tree/module$d/assets/sounds.tar.gz"
+    printf '#!/bin/sh\n' >"tree/module$d/build.sh"
+    chmod +x "tree/module$d/build.sh"
+    ln -s include/unit01.h "tree/module$d/main.h"
+done
+find . -exec touch -h -d '2024-01-01 12:00' {} +
+capture ls-laR "ls -laRgG --color=always --time-style=long-iso tree"
+
+# vim scrolling, editing and splitting a copy of the terminal emulator
+cp "$repo/src/terminal.c" edit.c
+cat >session.vim <<'EOF'
+set nocompatible
+syntax on
+set number
+set laststatus=2
+set ruler
+set hlsearch
+for i in range(40)
+  execute "normal! \<C-d>"
+  redraw
+endfor
+for i in range(25)
+  execute "normal! \<C-u>"
+  redraw
+endfor
+normal! gg
+for i in range(20)
+  execute "normal! 3jA // checked\<Esc>"
+  redraw
+endfor
+/terminal_put
+redraw
+split
+redraw
+for i in range(15)
+  execute "normal! \<C-e>"
+  redraw
+endfor
+qa!
+EOF
+capture vim-session "vim -N -u NONE -i NONE -n -S session.vim edit.c"
+
+# top in colour with the summary area hidden (l, then t and m cycled off),
+# saved to toprc with W before quitting, watching only processes started here
+(sleep 1; for key in z x b l t t t m m m W q; do printf $key; sleep 0.3; done) |
+    script -q -e -O /dev/null -c "stty cols 80 rows 24; top -n 1000" >/dev/null
+for i in 1 2; do
+    yes >/dev/null &
+    sleepers="$sleepers $!"
+done
+for i in 1 2 3 4; do
+    sleep 600 &
+    sleepers="$sleepers $!"
+done
+capture top "top -d 0.2 -n 30 -p $(echo $sleepers | tr ' ' ',')"
+
+# git log --graph -p over a scratch history with fixed names and dates
+git init -q -b main history
+cd history
+git config user.name "Example Developer"
+git config user.email dev@example.com
+step=0
+commit() {
+    step=$((step + 1))
+    git add -A
+    GIT_AUTHOR_DATE="@$((1704110400 + step * 3600)) +0000" GIT_COMMITTER_DATE="@$((1704110400 + step * 3600)) +0000" \
+        git commit -q -m "$1"
+}
+merge() {
+    step=$((step + 1))
+    GIT_AUTHOR_DATE="@$((1704110400 + step * 3600)) +0000" GIT_COMMITTER_DATE="@$((1704110400 + step * 3600)) +0000" \
+        git merge -q --no-ff -m "$2" "$1"
+}
+mkdir src
+cp "$repo/src/termcell.c" "$repo/src/termcell.h" "$repo/src/scrollback.c" "$repo/src/scrollback.h" src/
+commit "Add cell packing and scrollback storage"
+cp "$repo/src/terminal.c" "$repo/src/terminal.h" src/
+commit "Add the terminal emulator"
+git checkout -q -b rename
+sed -i 's/cursor_x/col/g; s/cursor_y/row/g' src/terminal.c src/terminal.h
+commit "Rename the cursor fields"
+sed -i 's/TermCell \*row/TermCell *line/g' src/terminal.c
+commit "Call row pointers lines"
+git checkout -q main
+sed -i '/^ *\/\/ /d' src/scrollback.c
+commit "Drop comments from the scrollback"
+cp "$repo/README.md" .
+commit "Add a README"
+merge rename "Merge the cursor renames"
+sed -i 's/TERM_MAX_ATTRS/TERM_ATTR_LIMIT/g' src/*.c src/*.h
+commit "Rename the attribute limit"
+capture git-log "git --no-pager log --color=always --graph --decorate --stat -p | head -c 250000"
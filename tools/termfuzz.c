@@ -0,0 +1,203 @@
+// Terminal parser fuzz harness. Built with LIBFUZZER=1 (clang) it is a libFuzzer
+// target; otherwise main() replays the files and directories it is given, such
+// as tools/corpus/terminal or inputs libFuzzer saved, under ASan/UBSan.
+// Every input also runs differentially: a second terminal parses it one byte
+// at a time, and must end each chunk in exactly the state terminal_feed left.
+#define _POSIX_C_SOURCE 200809L
+#include "types.h"
+#include "terminal.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static Terminal fuzz_term;
+static Terminal reference_term;
+
+// State the parser must never leave behind, whatever it was fed
+static void check_invariants(const Terminal *term) {
+    if (term->cursor_x < 0 || term->cursor_x >= term->cols || term->cursor_y < 0 ||
+        term->cursor_y >= term->rows || term->row_offset < 0 || term->row_offset >= term->rows ||
+        term->scroll_top < 0 || term->scroll_top > term->scroll_bottom || term->scroll_bottom >= term->rows ||
+        term->ansi_param_count < 0 || term->ansi_param_count > 16 || term->csi_buffer_len < 0 ||
+        term->csi_buffer_len >= (int)sizeof(term->csi_buffer)) {
+        fprintf(stderr, "termfuzz: invariant broken: cursor %d,%d margins %d-%d grid %dx%d\n", term->cursor_x,
+                term->cursor_y, term->scroll_top, term->scroll_bottom, term->cols, term->rows);
+        abort();
+    }
+}
+
+static void report_difference(const char *what, int x, int y) {
+    fprintf(stderr, "termfuzz: terminal_feed and terminal_parse_byte differ in %s (%d,%d)\n", what, x, y);
+    abort();
+}
+
+// The bulk path must leave the grid, cursor, modes and parser mid-sequence
+// state exactly as the per-byte state machine does
+static void check_same_state(const Terminal *a, const Terminal *b) {
+    if (a->cols != b->cols || a->rows != b->rows) {
+        report_difference("grid size", a->cols, a->rows);
+    }
+    if (a->cursor_x != b->cursor_x || a->cursor_y != b->cursor_y || a->wrap_pending != b->wrap_pending) {
+        report_difference("cursor", a->cursor_x, a->cursor_y);
+    }
+    if (a->scroll_top != b->scroll_top || a->scroll_bottom != b->scroll_bottom || a->autowrap != b->autowrap ||
+        a->insert_mode != b->insert_mode || a->app_cursor_keys != b->app_cursor_keys ||
+        a->charset_graphics != b->charset_graphics || a->alt_screen != b->alt_screen ||
+        a->cursor_visible != b->cursor_visible || a->bracketed_paste != b->bracketed_paste) {
+        report_difference("modes", a->scroll_top, a->scroll_bottom);
+    }
+    if (a->saved_cursor_x != b->saved_cursor_x || a->saved_cursor_y != b->saved_cursor_y ||
+        a->saved_fg != b->saved_fg || a->saved_bg != b->saved_bg || a->saved_attrs != b->saved_attrs ||
+        a->saved_charset_graphics != b->saved_charset_graphics) {
+        report_difference("saved cursor", a->saved_cursor_x, a->saved_cursor_y);
+    }
+    if (a->parse_state != b->parse_state || a->utf8_codepoint != b->utf8_codepoint ||
+        a->utf8_min != b->utf8_min || a->utf8_remaining != b->utf8_remaining ||
+        a->ansi_param_count != b->ansi_param_count || a->csi_buffer_len != b->csi_buffer_len ||
+        memcmp(a->ansi_params, b->ansi_params, sizeof(a->ansi_params)) != 0 ||
+        memcmp(a->csi_buffer, b->csi_buffer, (size_t)a->csi_buffer_len) != 0) {
+        report_difference("parser state", (int)a->parse_state, (int)b->parse_state);
+    }
+    if (a->current_fg != b->current_fg || a->current_bg != b->current_bg ||
+        a->current_attrs != b->current_attrs || a->current_attr != b->current_attr) {
+        report_difference("current attribute", a->current_attr, b->current_attr);
+    }
+    for (int y = 0; y < a->rows; y++) {
+        const TermCell *row_a = a->cells + (size_t)terminal_physical_row(a->row_offset, a->rows, y) * a->cols;
+        const TermCell *row_b = b->cells + (size_t)terminal_physical_row(b->row_offset, b->rows, y) * b->cols;
+        for (int x = 0; x < a->cols; x++) {
+            if (row_a[x] != row_b[x]) {
+                report_difference("cell", x, y);
+            }
+        }
+    }
+    if (a->history.count != b->history.count) {
+        report_difference("scrollback length", a->history.count, b->history.count);
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    terminal_init(&fuzz_term);
+    terminal_init(&reference_term);
+    if (size == 0) {
+        terminal_destroy(&fuzz_term);
+        terminal_destroy(&reference_term);
+        return 0;
+    }
+
+    // The first byte picks the read size, so chunk boundaries fall inside
+    // escape sequences and UTF-8 characters the way PTY reads do
+    size_t chunk = 1 + data[0] % 97;
+    int chunks = 0;
+    for (size_t off = 1; off < size; off += chunk, chunks++) {
+        size_t n = size - off < chunk ? size - off : chunk;
+        // Alternate the bulk path and the per-byte state machine mid-stream;
+        // the reference only ever takes the per-byte path
+        if (chunks % 3 == 2) {
+            for (size_t i = 0; i < n; i++) {
+                terminal_parse_byte(&fuzz_term, data[off + i]);
+            }
+        } else {
+            terminal_feed(&fuzz_term, data + off, n);
+        }
+        for (size_t i = 0; i < n; i++) {
+            terminal_parse_byte(&reference_term, data[off + i]);
+        }
+        check_invariants(&fuzz_term);
+        check_same_state(&fuzz_term, &reference_term);
+
+        // Now and then resize, look back into history and publish, as the
+        // main loop does between reads. The reference does the same, since
+        // composing history can intern attributes.
+        if (chunks % 16 == 15) {
+            int cols = 1 + data[off] % TERM_MAX_COLS;
+            int rows = 1 + data[off + n - 1] % TERM_MAX_ROWS;
+            terminal_resize(&fuzz_term, cols, rows);
+            terminal_resize(&reference_term, cols, rows);
+            check_invariants(&fuzz_term);
+            check_same_state(&fuzz_term, &reference_term);
+        }
+        if (chunks % 8 == 7) {
+            Terminal *terms[2] = {&fuzz_term, &reference_term};
+            for (int t = 0; t < 2; t++) {
+                terminal_scroll_view(terms[t], (int)(data[off] % 64) - 16);
+                terminal_publish(terms[t]);
+                terminal_scroll_view(terms[t], -terms[t]->view_offset);
+            }
+        }
+    }
+    terminal_publish(&fuzz_term);
+    terminal_destroy(&fuzz_term);
+    terminal_destroy(&reference_term);
+    return 0;
+}
+
+#ifndef TSS_LIBFUZZER
+static int replay_file(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *data = malloc(size > 0 ? (size_t)size : 1);
+    size_t len = data ? fread(data, 1, size > 0 ? (size_t)size : 0, file) : 0;
+    fclose(file);
+    if (!data) {
+        fprintf(stderr, "termfuzz: out of memory\n");
+        return 0;
+    }
+    LLVMFuzzerTestOneInput(data, len);
+    free(data);
+    return 1;
+}
+
+static int replay_path(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        perror(path);
+        return 0;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        return replay_file(path);
+    }
+    DIR *dir = opendir(path);
+    if (!dir) {
+        perror(path);
+        return 0;
+    }
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char child[4096];
+        snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        if (stat(child, &st) == 0 && S_ISREG(st.st_mode)) {
+            count += replay_file(child);
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <file or directory>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    int count = 0;
+    for (int i = 1; i < argc; i++) {
+        count += replay_path(argv[i]);
+    }
+    printf("termfuzz: replayed %d inputs\n", count);
+    return count > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#endif